@@ -5,13 +5,16 @@ in vec2 TexCoord;
 in float BlockType;
 in vec3 Normal;
 
-struct Light {
-    vec3 direction;
-    vec3 ambient;
-    vec3 diffuse;
+// Per frame state shared by every shader, see gfx::FrameUniforms
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 sunDirection;
+    vec4 sunAmbient;
+    vec4 sunDiffuse;
+    vec4 cameraPosition;
 };
 
-uniform Light SunLight;
 uniform sampler2D textureAtlas;
 
 void main()
@@ -34,7 +37,7 @@ void main()
     vec4 texColor = texture(textureAtlas, finalUV) * Biomecolor;
 
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(-SunLight.direction);
+    vec3 lightDir = normalize(-sunDirection.xyz);
     float diff = max(dot(norm, lightDir), 0.0);
 
     float faceBrightness = 1.0;
@@ -43,8 +46,8 @@ void main()
     if (norm.y < -0.5) faceBrightness = 0.5; // Bottom is darkest
     // Top (Y > 0.5) stays at 1.0 (brightest)
 
-    vec3 ambient = SunLight.ambient * faceBrightness;
-    vec3 diffuse = SunLight.diffuse * diff;
+    vec3 ambient = sunAmbient.rgb * faceBrightness;
+    vec3 diffuse = sunDiffuse.rgb * diff;
 
     vec3 finalColor = texColor.rgb * (ambient + diffuse);
     FragColor = vec4(finalColor, 1.0);
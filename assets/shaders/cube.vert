@@ -3,18 +3,26 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec2 aTexCoord;
 layout(location = 2) in float aNormal;
 layout(location = 3) in float aBlockType;
+// Per draw (instanced), see gfx::DrawBatch
+layout(location = 4) in vec3 aChunkOffset;
 
 out vec2 TexCoord;
 out float BlockType;
 out vec3 Normal;
 
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 uChunkOffset;
+// Per frame state shared by every shader, see gfx::FrameUniforms
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 sunDirection;
+    vec4 sunAmbient;
+    vec4 sunDiffuse;
+    vec4 cameraPosition;
+};
 
 void main()
 {
-    vec3 worldPos = aPos + uChunkOffset;
+    vec3 worldPos = aPos + aChunkOffset;
     gl_Position = projection * view * vec4(worldPos, 1.0);
     float fx = fract(worldPos.x);
     float fy = fract(worldPos.y);
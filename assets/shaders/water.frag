@@ -3,20 +3,22 @@ out vec4 FragColor;
 
 in vec3 Normal;
 
-struct Light {
-    vec3 direction;
-    vec3 ambient;
-    vec3 diffuse;
+// Per frame state shared by every shader, see gfx::FrameUniforms
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 sunDirection;
+    vec4 sunAmbient;
+    vec4 sunDiffuse;
+    vec4 cameraPosition;
 };
 
-uniform Light SunLight;
-
 void main()
 {
     vec4 waterColor = vec4(0.0, 0.45, 0.65, 0.45);
 
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(-SunLight.direction);
+    vec3 lightDir = normalize(-sunDirection.xyz);
     float diff = max(dot(norm, lightDir), 0.0);
 
     float faceBrightness = 1.0;
@@ -24,8 +26,8 @@ void main()
     if (abs(norm.z) > 0.5) faceBrightness = 0.6;
     if (norm.y < -0.5) faceBrightness = 0.5;
 
-    vec3 ambient = SunLight.ambient * faceBrightness;
-    vec3 diffuse = SunLight.diffuse * diff;
+    vec3 ambient = sunAmbient.rgb * faceBrightness;
+    vec3 diffuse = sunDiffuse.rgb * diff;
 
     vec3 finalColor = waterColor.rgb * (ambient + diffuse);
     FragColor = vec4(finalColor, waterColor.a);
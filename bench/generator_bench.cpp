@@ -0,0 +1,79 @@
+// Headless side by side timing of the terrain generators.
+// Build in Release for meaningful numbers.
+#include "voxel/chunk.hpp"
+#include "voxel/terrain_generator.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace pop::voxel;
+
+namespace {
+constexpr int kGridRadius  = 4;  // (2R)^2 chunks per generator
+constexpr int kChunkVolume = Chunk::kVolume;
+constexpr int kColumns     = Chunk::kSize_x * Chunk::kSize_z;
+
+struct BenchResult {
+    double                   millis{};
+    std::vector<Voxel::Type> voxels;
+};
+
+BenchResult Run(const terrain::Generator& generator) {
+    BenchResult result;
+    result.voxels.reserve(static_cast<size_t>(4 * kGridRadius * kGridRadius) *
+                          kChunkVolume);
+    auto chunkData = std::make_unique<Voxel[]>(kChunkVolume);
+
+    for (int cx = -kGridRadius; cx < kGridRadius; cx++) {
+        for (int cz = -kGridRadius; cz < kGridRadius; cz++) {
+            glm::ivec3 offset{cx * Chunk::kSize_x, 0, cz * Chunk::kSize_z};
+
+            auto start = std::chrono::steady_clock::now();
+            generator.Populate({chunkData.get(), kChunkVolume}, offset);
+            auto end = std::chrono::steady_clock::now();
+            result.millis +=
+                std::chrono::duration<double, std::milli>(end - start).count();
+
+            for (int i = 0; i < kChunkVolume; i++)
+                result.voxels.push_back(chunkData[i].GetType());
+        }
+    }
+    return result;
+}
+
+void Report(const char* name, const BenchResult& result, int samplesPerChunk) {
+    const int    chunks = 4 * kGridRadius * kGridRadius;
+    const double voxelsPerSec =
+        static_cast<double>(chunks) * kChunkVolume / (result.millis / 1000.0);
+    std::printf("%-10s %8.2f ms total  %7.3f ms/chunk  %8.2f Mvoxel/s  "
+                "%6d noise samples/chunk\n",
+                name, result.millis, result.millis / chunks,
+                voxelsPerSec / 1e6, samplesPerChunk);
+}
+}  // namespace
+
+int main() {
+    // Warm up the noise singleton so its construction is not timed
+    terrain::TerrainGenerator::GetInstance();
+
+    terrain::DensityGenerator   density;
+    terrain::HeightMapGenerator heightMap;
+
+    auto densityResult   = Run(density);
+    auto heightMapResult = Run(heightMap);
+
+    // Both also sample the 2D noise once per column for the column cache
+    Report("density", densityResult, kChunkVolume + kColumns);
+    Report("heightmap", heightMapResult, kColumns);
+    std::printf("speedup    %.2fx\n",
+                densityResult.millis / heightMapResult.millis);
+
+    size_t same = 0;
+    for (size_t i = 0; i < densityResult.voxels.size(); i++)
+        same += densityResult.voxels[i] == heightMapResult.voxels[i];
+    std::printf("agreement  %.2f%% of voxels identical\n",
+                100.0 * same / densityResult.voxels.size());
+    return 0;
+}
@@ -0,0 +1,270 @@
+// Headless terrain throughput benchmark and output check.
+// Runs the full WorldGenPipeline over a fixed grid of chunks, reports
+// voxels/s and per-stage timings, and compares a hash of every chunk's voxels
+// against bench/golden/terrain_hashes.txt.
+//
+//   TerrainBench [--runs N] [--golden PATH] [--update-golden]
+//
+// Exits with 1 when any hash differs from the golden file. Regenerate the
+// file with --update-golden only when the terrain is meant to change.
+// Build in Release for meaningful numbers.
+#include "voxel/chunk.hpp"
+#include "voxel/chunk_coord.hpp"
+#include "voxel/terrain_generator.hpp"
+#include "voxel/world_gen.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef TERRAIN_GOLDEN_PATH
+#define TERRAIN_GOLDEN_PATH "bench/golden/terrain_hashes.txt"
+#endif
+
+using namespace pop::voxel;
+
+namespace {
+// Away from the origin so negative and positive coords are both covered
+constexpr ChunkCoord kGridOrigin{-5, -3};
+constexpr int        kGridSize = 8;  // kGridSize^2 chunks per config
+constexpr int        kLods[]   = {1, 2, 4, 8};
+
+using Clock = std::chrono::steady_clock;
+
+double MillisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
+// FNV-1a over the voxel types of a chunk
+uint64_t HashVoxels(std::span<const Voxel> voxels) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const auto& voxel : voxels) {
+        hash ^= static_cast<uint8_t>(voxel.GetType());
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+struct Config {
+    std::string                                          name;
+    std::function<std::unique_ptr<terrain::Generator>()> makeGenerator;
+    int                                                  lod;
+};
+
+struct StageTimes {
+    double density{}, surface{}, decoration{};
+    double Total() const { return density + surface + decoration; }
+};
+
+struct RunResult {
+    StageTimes            times;
+    std::vector<uint64_t> hashes;  // grid order, x major
+};
+
+RunResult RunConfig(const Config& config) {
+    RunResult result;
+    // Fresh pipeline: a warm column cache would skip most of the noise
+    terrain::WorldGenPipeline pipeline(config.makeGenerator());
+
+    std::vector<ChunkCoord>             coords;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    for (int x = 0; x < kGridSize; x++) {
+        for (int z = 0; z < kGridSize; z++) {
+            ChunkCoord coord = kGridOrigin + ChunkCoord{x, z};
+            coords.push_back(coord);
+            chunks.push_back(
+                std::make_unique<Chunk>(ChunkToOffset(coord), config.lod));
+        }
+    }
+
+    // Stage by stage over the whole grid, the same order ChunkManager uses
+    auto start = Clock::now();
+    for (size_t i = 0; i < chunks.size(); i++)
+        pipeline.Generate(*chunks[i], coords[i], Chunk::GenStage::kDensity);
+    result.times.density = MillisSince(start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < chunks.size(); i++)
+        pipeline.Generate(*chunks[i], coords[i], Chunk::GenStage::kSurface);
+    result.times.surface = MillisSince(start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < chunks.size(); i++) {
+        pipeline.ApplyPendingWrites(*chunks[i], coords[i]);
+        pipeline.Generate(*chunks[i], coords[i], Chunk::GenStage::kDecorated);
+    }
+    for (size_t i = 0; i < chunks.size(); i++)
+        pipeline.ApplyPendingWrites(*chunks[i], coords[i]);
+    result.times.decoration = MillisSince(start);
+
+    for (const auto& chunk : chunks)
+        result.hashes.push_back(HashVoxels(chunk->Voxels()));
+    return result;
+}
+
+using GoldenKey = std::pair<std::string, std::pair<int, int>>;
+
+bool LoadGolden(const std::string& path, std::map<GoldenKey, uint64_t>& out) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        std::string        name, hex;
+        int                x, z;
+        if (!(in >> name >> x >> z >> hex)) {
+            std::fprintf(stderr, "Malformed golden line: %s\n", line.c_str());
+            continue;
+        }
+        out[{name, {x, z}}] = std::stoull(hex, nullptr, 16);
+    }
+    return true;
+}
+
+bool WriteGolden(const std::string& path, const std::vector<Config>& configs,
+                 const std::vector<RunResult>& results) {
+    std::ofstream file(path);
+    if (!file) return false;
+    file << "# TerrainBench golden hashes: config chunk_x chunk_z fnv1a64\n";
+    for (size_t c = 0; c < configs.size(); c++) {
+        for (int i = 0; i < kGridSize * kGridSize; i++) {
+            char hex[17];
+            std::snprintf(hex, sizeof(hex), "%016" PRIx64,
+                          results[c].hashes[i]);
+            file << configs[c].name << ' ' << kGridOrigin.x + i / kGridSize
+                 << ' ' << kGridOrigin.z + i % kGridSize << ' ' << hex
+                 << '\n';
+        }
+    }
+    return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    int         runs         = 3;
+    bool        updateGolden = false;
+    std::string goldenPath   = TERRAIN_GOLDEN_PATH;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--update-golden")) {
+            updateGolden = true;
+        } else if (!std::strcmp(argv[i], "--runs") && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--golden") && i + 1 < argc) {
+            goldenPath = argv[++i];
+        } else {
+            std::fprintf(stderr,
+                         "Usage: %s [--runs N] [--golden PATH] "
+                         "[--update-golden]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+
+    // Warm up the noise singleton so its construction is not timed
+    terrain::TerrainGenerator::GetInstance();
+
+    std::vector<Config> configs;
+    for (int lod : kLods) {
+        configs.push_back({"density_lod" + std::to_string(lod),
+                           [] {
+                               return std::make_unique<
+                                   terrain::DensityGenerator>();
+                           },
+                           lod});
+        configs.push_back({"heightmap_lod" + std::to_string(lod),
+                           [] {
+                               return std::make_unique<
+                                   terrain::HeightMapGenerator>();
+                           },
+                           lod});
+    }
+
+    std::printf("%d chunks per config, best of %d runs\n",
+                kGridSize * kGridSize, runs);
+    std::printf("%-16s %10s %10s %10s %10s %12s\n", "config", "density",
+                "surface", "decorate", "total ms", "Mvoxel/s");
+
+    std::vector<RunResult> results;
+    for (const auto& config : configs) {
+        RunResult best;
+        for (int r = 0; r < runs; r++) {
+            RunResult run = RunConfig(config);
+            if (r == 0) {
+                best = std::move(run);
+                continue;
+            }
+            if (run.hashes != best.hashes) {
+                std::fprintf(stderr, "%s: output differs between runs\n",
+                             config.name.c_str());
+                return 1;
+            }
+            // Best per stage, the minimum is the least noisy estimate
+            best.times.density =
+                std::min(best.times.density, run.times.density);
+            best.times.surface =
+                std::min(best.times.surface, run.times.surface);
+            best.times.decoration =
+                std::min(best.times.decoration, run.times.decoration);
+        }
+        // Voxels as seen by the world: a low detail cell stands for lod^3
+        double voxels = static_cast<double>(kGridSize) * kGridSize *
+                        Chunk::kVolume;
+        std::printf("%-16s %10.2f %10.2f %10.2f %10.2f %12.2f\n",
+                    config.name.c_str(), best.times.density,
+                    best.times.surface, best.times.decoration,
+                    best.times.Total(),
+                    voxels / (best.times.Total() / 1000.0) / 1e6);
+        results.push_back(std::move(best));
+    }
+
+    if (updateGolden) {
+        if (!WriteGolden(goldenPath, configs, results)) {
+            std::fprintf(stderr, "Could not write %s\n", goldenPath.c_str());
+            return 1;
+        }
+        std::printf("Golden hashes written to %s\n", goldenPath.c_str());
+        return 0;
+    }
+
+    std::map<GoldenKey, uint64_t> golden;
+    if (!LoadGolden(goldenPath, golden)) {
+        std::fprintf(stderr, "Could not read %s, run with --update-golden\n",
+                     goldenPath.c_str());
+        return 1;
+    }
+    int mismatches = 0, missing = 0;
+    for (size_t c = 0; c < configs.size(); c++) {
+        for (int i = 0; i < kGridSize * kGridSize; i++) {
+            int  x  = kGridOrigin.x + i / kGridSize;
+            int  z  = kGridOrigin.z + i % kGridSize;
+            auto it = golden.find({configs[c].name, {x, z}});
+            if (it == golden.end()) {
+                missing++;
+            } else if (it->second != results[c].hashes[i]) {
+                if (mismatches++ < 10)
+                    std::fprintf(stderr, "Mismatch: %s chunk (%d, %d)\n",
+                                 configs[c].name.c_str(), x, z);
+            }
+        }
+    }
+    if (mismatches || missing) {
+        std::fprintf(stderr, "FAILED: %d mismatched, %d missing hashes\n",
+                     mismatches, missing);
+        return 1;
+    }
+    std::printf("All %zu chunk hashes match %s\n",
+                configs.size() * kGridSize * kGridSize, goldenPath.c_str());
+    return 0;
+}
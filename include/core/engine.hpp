@@ -5,12 +5,19 @@
 #include "renderable.hpp"
 // #include "resource_manager.hpp"
 
+#include <functional>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "GLFW/glfw3.h"
+#include "graphics/frame_uniforms.hpp"
 #include "graphics/shader.hpp"
+#include "graphics/vertex_buffers.hpp"
 
+#include "util/frame_times.hpp"
+#include "util/frustum.hpp"
 #include "util/safe_queue.hpp"
 
 namespace pop::core {
@@ -22,6 +29,23 @@ struct RenderCmd {
 };
 class Engine {
    public:
+    // Renderables of the last frame, both passes
+    struct RenderStats {
+        size_t drawn;
+        size_t culled;
+        size_t drawCalls;  // a submitted batch counts once
+        // Time spent ordering the transparent pass, 0 on frames that
+        // reused the previous order
+        float transparentSortMillis;
+    };
+    // Caps the uploads of one frame: stops after maxBytes or maxMillis,
+    // whichever comes first. The renderable nearest the camera is always
+    // uploaded so one big mesh cannot stall the queue.
+    struct UploadBudget {
+        size_t maxBytes  = 4 << 20;
+        float  maxMillis = 2.0f;
+    };
+
     Engine(glm::mat4 projectionMatrix, GLFWwindow* window);
     ~Engine() = default;
 
@@ -37,13 +61,45 @@ class Engine {
     void UpdateRenderable(std::shared_ptr<Renderable> renderable);
     void RemoveRenderable(std::shared_ptr<Renderable> renderable);
 
+    // Programs reading the FrameData block get it bound to
+    // gfx::FrameUniforms::kBinding
     void AddShaderProgram(std::unique_ptr<gfx::ShaderProgram> prog);
 
+    // Called on the render thread once per frame, after input is processed
+    void SetFrameCallback(std::function<void()> callback);
+
     void Run();
 
     float GetDeltaTime() const;
     bool  IsRunning() const;
 
+    // Skips renderables whose GetWorldBounds() lies outside the view
+    // frustum. On by default.
+    void        SetFrustumCulling(bool enabled) { frustum_culling_ = enabled; }
+    // The transparent pass is drawn back to front, re-sorted when the
+    // camera moved this far since the last sort or the set changed
+    void SetTransparentResortDistance(float distance) {
+        transparent_resort_distance_ = distance;
+    }
+    bool        IsFrustumCulling() const { return frustum_culling_; }
+    RenderStats GetRenderStats() const { return render_stats_; }
+
+    // Without the budget every queued upload happens in the frame it
+    // arrives. On by default.
+    void SetUploadBudget(const UploadBudget& budget) {
+        upload_budget_ = budget;
+    }
+    void SetUploadBudgetEnabled(bool enabled) {
+        upload_budget_enabled_ = enabled;
+    }
+    bool   IsUploadBudgetEnabled() const { return upload_budget_enabled_; }
+    size_t GetPendingUploads() const { return pending_uploads_.size(); }
+    // Frame times since the last ResetFrameTimes
+    util::FrameTimes::Percentiles GetFrameTimes() const {
+        return frame_times_.Get();
+    }
+    void ResetFrameTimes() { frame_times_.Clear(); }
+
     void          SetupCallbacks();
     InputManager& GetInputManager() { return input_manager_; }
 
@@ -53,9 +109,30 @@ class Engine {
 
    private:
     void Render();
+    // Writes view, projection, sun and camera into frame_ubo_
+    void UploadFrameUniforms(const glm::mat4& viewMatrix);
+    // Draws one pass, skipping what is outside frustum when culling
+    // Shader first, then texture, then vertex array: the order from the
+    // most to the least expensive state change
+    static uint64_t MakeSortKey(gfx::ShaderHandle shader, GLuint texture,
+                                GLuint vertexArray);
+    void            DrawRenderables(
+        const std::unordered_set<std::shared_ptr<Renderable>>& renderables,
+        const util::Frustum&                                    frustum);
+    // Draws transparent_renderables_ in transparent_order_
+    void DrawTransparent(const util::Frustum& frustum);
+    // Farthest first, by the distance to the center of the world bounds
+    void SortTransparent(const glm::vec3& cameraPos);
+    // Appends drawable to draw_list_ unless it is culled or has no program
+    void AddDrawItem(Renderable* drawable, const util::Frustum& frustum);
+    // Draws draw_list_ in order, batching neighbors with the same key
+    void SubmitDrawList();
     void UpdateDeltaTime();
     void ProcessInput();
     void ProcessCommands();
+    // Uploads pending renderables nearest the camera first, within
+    // upload_budget_ when it is enabled
+    void UploadPending();
 
    private:
     float last_frame_time_{};
@@ -75,6 +152,35 @@ class Engine {
 
     std::shared_ptr<gfx::Camera> main_camera_{};
     glm::mat4                    projection_matrix_{};
+    gfx::FrameUniforms           frame_uniforms_{};
+    gfx::GLBuffer frame_ubo_{gfx::BufferType::kUniformBuffer, true};
+    std::function<void()>        frame_callback_{};
+    bool                         frustum_culling_{true};
+    RenderStats                  render_stats_{};
+    util::FrameTimes             frame_times_;
+
+    // Added or updated renderables waiting for their upload. Added ones
+    // join the draw sets only once uploaded.
+    struct PendingUpload {
+        std::shared_ptr<Renderable> renderable;
+        bool                        add;
+    };
+    std::unordered_map<Renderable*, PendingUpload> pending_uploads_;
+    UploadBudget                                   upload_budget_{};
+    bool                                           upload_budget_enabled_{true};
+    // Visible renderables of the current pass, sorted by MakeSortKey
+    struct DrawItem {
+        uint64_t            key;
+        Renderable*         renderable;
+        gfx::ShaderProgram* program;
+    };
+    std::vector<DrawItem> draw_list_;
+    gfx::DrawBatch        batch_;
+
+    std::vector<Renderable*> transparent_order_;
+    glm::vec3                sorted_from_{};
+    bool                     transparent_order_dirty_{true};
+    float                    transparent_resort_distance_{8.0f};
 
     // gfx::ResourceManager resource_manager_;
 };
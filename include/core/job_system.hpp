@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace pop::core {
+namespace detail {
+struct JobNode;
+}
+
+// Completion handle of a submitted job. Cheap to copy, empty handles count
+// as finished.
+class JobHandle {
+   public:
+    JobHandle() = default;
+    bool IsDone() const;
+
+   private:
+    friend class JobSystem;
+    explicit JobHandle(std::shared_ptr<detail::JobNode> node)
+        : node_{std::move(node)} {}
+    std::shared_ptr<detail::JobNode> node_;
+};
+
+// Work-stealing scheduler. Every worker owns a deque: it pushes and pops its
+// own jobs at the back and steals from the front of the others. A job only
+// becomes runnable once all its dependencies finished, so it never blocks a
+// worker waiting for them.
+class JobSystem {
+   public:
+    using Job = std::function<void()>;
+
+    struct Stats {
+        size_t   workers;
+        size_t   queued;  // runnable jobs not started yet
+        size_t   waiting;  // jobs still waiting for a dependency
+        uint64_t executed;
+        uint64_t steals;
+    };
+
+    // 0 workers picks one per hardware thread, minus the submitting thread
+    explicit JobSystem(size_t workers = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&)            = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    JobHandle Submit(Job job, std::span<const JobHandle> dependencies = {});
+    JobHandle Submit(Job job, std::initializer_list<JobHandle> dependencies) {
+        return Submit(std::move(job), std::span{dependencies.begin(),
+                                                dependencies.size()});
+    }
+
+    // Runs queued jobs on the calling thread until handle is done
+    void Wait(const JobHandle& handle);
+    void WaitAll(std::span<const JobHandle> handles);
+
+    Stats  GetStats() const;
+    size_t WorkerCount() const { return workers_.size(); }
+
+   private:
+    using NodePtr = std::shared_ptr<detail::JobNode>;
+    struct WorkQueue {
+        std::mutex          mutex;
+        std::deque<NodePtr> jobs;
+    };
+    static constexpr size_t kNoQueue = static_cast<size_t>(-1);
+
+    void WorkerLoop(size_t index);
+    // Pops from the back of queue index, or steals from the front of another
+    // one. index is kNoQueue on threads that are not workers.
+    NodePtr FindJob(size_t index);
+    bool    TryRunOne(size_t index);
+    void    Schedule(NodePtr node);
+    void    Execute(const NodePtr& node);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread>                workers_;
+
+    std::mutex              sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<bool>       stop_{false};
+
+    std::atomic<size_t>   queued_{0}, waiting_{0}, next_queue_{0};
+    std::atomic<uint64_t> executed_{0}, steals_{0};
+};
+}  // namespace pop::core
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "gl/gl_types.hpp"
+#include "graphics/draw_batch.hpp"
 #include "graphics/shader.hpp"
+#include "util/frustum.hpp"
 #include <glad/glad.h>
 #include <memory>
+#include <optional>
 
 namespace pop {
 class Renderable {
@@ -14,6 +17,20 @@ class Renderable {
     virtual void              Draw(gfx::ShaderProgram* const) = 0;
     virtual gfx::ShaderHandle GetShaderProgId() const         = 0;
     virtual bool              IsTransparent() const           = 0;
+    // World space box around everything Draw() renders, used for culling.
+    // Renderables without one are always drawn.
+    virtual std::optional<util::AABB> GetWorldBounds() const {
+        return std::nullopt;
+    }
+    // Queues this draw into batch instead of Draw(). Renderables that
+    // cannot be batched return false and are drawn on their own.
+    virtual bool AddToBatch(gfx::DrawBatch& /*batch*/) { return false; }
+    // State Draw() binds, used to sort draws so that neighbors share it. 0
+    // when unknown.
+    virtual GLuint GetTextureId() const { return 0; }
+    virtual GLuint GetVertexArrayId() const { return 0; }
+    // Bytes the next Upload() sends to the GPU, 0 when unknown
+    virtual size_t GetUploadSize() const { return 0; }
 
    private:
 };
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+
+namespace pop::gfx {
+// CPU side sub-allocator for a buffer of capacity units (vertices, bytes,
+// ...). Best fit over a free list that coalesces neighboring blocks on
+// Free. Knows nothing about GL.
+class BufferAllocator {
+   public:
+    struct Range {
+        size_t offset;
+        size_t size;
+    };
+    struct Stats {
+        size_t capacity;
+        size_t used;
+        size_t peak;  // highest used so far
+        size_t freeBlocks;
+        size_t largestFree;
+        // 0 when all free space is one block, towards 1 the more it is
+        // split into small blocks
+        float fragmentation;
+    };
+
+    explicit BufferAllocator(size_t capacity);
+
+    // nullopt when no free block is large enough, see Grow
+    std::optional<Range> Allocate(size_t size);
+    // range must come from Allocate and not be freed twice
+    void Free(const Range& range);
+    // Appends newCapacity - capacity free units at the end
+    void Grow(size_t newCapacity);
+
+    Stats  GetStats() const;
+    size_t Capacity() const { return capacity_; }
+
+   private:
+    void InsertFree(size_t offset, size_t size);
+    void EraseFree(std::map<size_t, size_t>::iterator it);
+
+    size_t capacity_;
+    size_t used_{};
+    size_t peak_{};
+    // Free blocks by offset, for coalescing, and by size, for best fit
+    std::map<size_t, size_t>            free_by_offset_;
+    std::set<std::pair<size_t, size_t>> free_by_size_;
+};
+}  // namespace pop::gfx
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "glm/vec3.hpp"
+#include "graphics/rendertypes.hpp"
+#include "graphics/vertex_buffers.hpp"
+#include "graphics/vertex_pool.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace pop::gfx {
+// Draws of many meshes from one VertexPool that share a shader and their
+// textures, submitted together. The world offset of each draw is the per
+// instance attribute kOffsetAttribute instead of a uniform, so nothing
+// changes between draws.
+//
+// With GL 4.3 the whole batch is a single glMultiDrawArraysIndirect;
+// otherwise it falls back to one glDrawArrays per mesh with the offset set
+// as a constant attribute. Render thread only.
+class DrawBatch {
+   public:
+    static constexpr GLuint kOffsetAttribute = 4;
+
+    using Textures = std::vector<std::shared_ptr<rtypes::TextureBinding>>;
+
+    // The pool and textures of the first draw are used for the whole
+    // batch, every later draw must use the same ones
+    void Add(VertexPool& pool, const Textures& textures, GLint first,
+             GLsizei count, const glm::vec3& offset);
+    // Issues the draws with the current program and clears the batch
+    void Submit();
+    bool   Empty() const { return commands_.empty(); }
+    size_t Size() const { return commands_.size(); }
+
+    static bool SupportsIndirect();
+
+   private:
+    // Layout fixed by GL
+    struct DrawArraysIndirectCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    VertexPool*                            pool_{};
+    const Textures*                        textures_{};
+    std::vector<DrawArraysIndirectCommand> commands_;
+    std::vector<glm::vec3>                 offsets_;
+    GLBuffer command_buffer_{BufferType::kDrawIndirectBuffer, true};
+    GLBuffer offset_buffer_{BufferType::kArrayBuffer, true};
+};
+}  // namespace pop::gfx
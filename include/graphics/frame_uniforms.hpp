@@ -0,0 +1,29 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+
+#include <cstddef>
+
+namespace pop::gfx {
+// CPU copy of the std140 FrameData uniform block the shaders share. The
+// engine writes it once per frame into a buffer bound at kBinding. Every
+// vec3 is stored as a vec4, as std140 pads it anyway.
+struct FrameUniforms {
+    static constexpr GLuint      kBinding   = 0;
+    static constexpr const char* kBlockName = "FrameData";
+
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 sunDirection;  // direction the light travels in
+    glm::vec4 sunAmbient;
+    glm::vec4 sunDiffuse;
+    glm::vec4 cameraPosition;
+};
+// Must match the block declared in assets/shaders
+static_assert(offsetof(FrameUniforms, projection) == 64);
+static_assert(offsetof(FrameUniforms, sunDirection) == 128);
+static_assert(offsetof(FrameUniforms, cameraPosition) == 176);
+static_assert(sizeof(FrameUniforms) == 192);
+}  // namespace pop::gfx
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+namespace pop::gfx {
+// Remembers the program, vertex array and textures bound on the render
+// thread's context and skips calls that would not change them. Every bind
+// of these three must go through it (ShaderProgram::use, VertexArray::Bind,
+// Texture::Bind do), or the cache goes stale.
+class GLStateCache {
+   public:
+    struct Counter {
+        uint64_t issued;
+        uint64_t skipped;
+    };
+    struct Stats {
+        Counter programs, vertexArrays, textures;
+    };
+
+    static GLStateCache& GetInstance() {
+        static GLStateCache instance;
+        return instance;
+    }
+
+    GLStateCache(const GLStateCache&)            = delete;
+    GLStateCache(GLStateCache&&)                 = delete;
+    GLStateCache& operator=(const GLStateCache&) = delete;
+    GLStateCache& operator=(GLStateCache&&)      = delete;
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vertexArray);
+    // Also makes unit the active texture unit
+    void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    // GL unbinds deleted objects, so a new object reusing the name must not
+    // be mistaken for the bound one
+    void OnProgramDeleted(GLuint program);
+    void OnVertexArrayDeleted(GLuint vertexArray);
+    void OnTextureDeleted(GLuint texture);
+    // Forgets everything, e.g. after GL calls that bypassed the cache
+    void Invalidate();
+
+    Stats GetStats() const { return stats_; }
+    void  ResetStats() { stats_ = {}; }
+
+   private:
+    GLStateCache() = default;
+
+    static constexpr GLuint kUnknown  = ~0u;
+    static constexpr GLuint kMaxUnits = 32;
+    // target and texture, {} while unknown
+    using TextureBinding = std::pair<GLenum, GLuint>;
+
+    GLuint                                program_{kUnknown};
+    GLuint                                vertex_array_{kUnknown};
+    GLuint                                active_unit_{kUnknown};
+    std::array<TextureBinding, kMaxUnits> textures_{};
+    Stats                                 stats_{};
+};
+}  // namespace pop::gfx
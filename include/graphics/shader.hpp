@@ -2,8 +2,11 @@
 
 #include "gl/gl_types.hpp"
 #include "glm/fwd.hpp"
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 
 namespace pop::gfx {
 
@@ -48,6 +51,11 @@ class Shader {
 
 class ShaderProgram {
    public:
+    // What glGetUniformLocation returns, -1 for unknown names. Setting -1 is
+    // a no-op in GL.
+    using UniformLocation                       = GLint;
+    static constexpr UniformLocation kNoUniform = -1;
+
     explicit ShaderProgram();
     ~ShaderProgram();
 
@@ -58,7 +66,8 @@ class ShaderProgram {
     ShaderProgram& operator=(ShaderProgram&&) noexcept;
     // Attatchs the shader to the program
     void Attach(const Shader& shader);
-    // Link all the attatched shaders
+    // Link all the attatched shaders, then caches every active uniform's
+    // location
     bool Link();
     // starts using this shader program from now on
     void use();
@@ -67,6 +76,13 @@ class ShaderProgram {
     // Returns last error message (empty if none)
     std::string GetError() const { return error_msg_; }
 
+    // Points the uniform block name at binding. False when the program has
+    // no such active block.
+    bool BindUniformBlock(std::string_view name, GLuint binding);
+    // Hash lookup in the locations cached by Link, no GL call. Resolve once
+    // and use the location overloads below on hot paths.
+    UniformLocation GetUniformLocation(std::string_view name) const;
+
     void SetUniformBool(std::string_view name, bool value);
     void SetUniformInt(std::string_view name, int value);
     void SetUniformFloat(std::string_view name, float value);
@@ -76,8 +92,32 @@ class ShaderProgram {
                           float w);
     void SetUniformMat4(std::string_view name, glm::mat4 ptr, bool transpose);
 
+    void SetUniformBool(UniformLocation location, bool value);
+    void SetUniformInt(UniformLocation location, int value);
+    void SetUniformFloat(UniformLocation location, float value);
+    void SetUniformFloat2(UniformLocation location, float x, float y);
+    void SetUniformFloat3(UniformLocation location, float x, float y,
+                          float z);
+    void SetUniformFloat4(UniformLocation location, float x, float y,
+                          float z, float w);
+    void SetUniformMat4(UniformLocation location, const glm::mat4& mat,
+                        bool transpose);
+
    private:
+    // Lets the cache be searched with a string_view without building a
+    // std::string per lookup
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+    void CacheUniformLocations();
+
     ShaderHandle program_id_{};
     std::string  error_msg_{};
+    std::unordered_map<std::string, UniformLocation, StringHash,
+                       std::equal_to<>>
+        uniform_locations_;
 };
 }  // namespace pop::gfx
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "graphics/vertex_buffers.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+
+namespace pop::gfx {
+// Staging ring for streaming uploads. Data is written into the ring on the
+// CPU and moved to its destination buffer by the GPU with
+// glCopyBufferSubData, so the driver never makes its own staging copy.
+//
+// With GL 4.4 or ARB_buffer_storage the ring is mapped once, persistently
+// and coherently. It is split into kSegments, each guarded by a fence put
+// after the last copy reading it: writing into a segment again first waits
+// for that fence. Without buffer storage every write maps its range
+// unsynchronized, and the ring is orphaned instead of reused when it wraps.
+//
+// When mapped, producers on other threads can also Stage data into a window
+// of the ring the render thread opened, and hand the returned Staged to the
+// render thread for CopyStaged: the render thread then only issues the GPU
+// copy. Staged data is lost once the ring comes around to it again, so the
+// producer keeps its own copy to fall back to Copy with.
+//
+// Render thread only, except for Stage.
+class StreamBuffer {
+   public:
+    static constexpr int kSegments = 4;
+
+    struct Stats {
+        size_t bytes;
+        size_t copies;
+        size_t waits;  // fence waits that had to block
+        size_t wraps;
+        size_t staged;   // copies written into the ring by their producer
+        size_t expired;  // staged data overwritten before its copy
+        bool   persistent;
+    };
+    // Data a producer wrote into the ring. position counts bytes from the
+    // start of the first lap, so it also tells when it was overwritten.
+    struct Staged {
+        uint64_t position;
+        size_t   bytes;
+    };
+
+    explicit StreamBuffer(size_t capacity);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&)            = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // Copies bytes of data to dstOffset in the buffer dst. Larger writes
+    // than a segment are split.
+    void Copy(GLuint dst, GLintptr dstOffset, const void* data, size_t bytes);
+    // Thread safe. Writes data into the open window, nullopt when there is
+    // no room or the ring is not mapped.
+    std::optional<Staged> Stage(const void* data, size_t bytes);
+    // Copies staged to dstOffset in dst. False when it was overwritten.
+    bool CopyStaged(GLuint dst, GLintptr dstOffset, const Staged& staged);
+
+    bool  IsPersistent() const { return mapped_ != nullptr; }
+    Stats GetStats() const { return stats_; }
+
+    static bool SupportsPersistentMapping();
+
+   private:
+    // A segment sized range producers Stage into. Closed windows take no
+    // more writes; their data stays valid until the ring reaches them.
+    struct Window {
+        std::byte*          data;
+        uint64_t            position;
+        size_t              size;
+        std::atomic<size_t> used{};
+        std::atomic<int>    writers{};
+        std::atomic<bool>   closed{};
+    };
+
+    // Ring offset for the next bytes, at most one segment
+    size_t Reserve(size_t bytes);
+    void   WaitSegment(int segment);
+    void   FenceSegment(int segment);
+    int    SegmentOf(size_t offset) const {
+        return static_cast<int>(offset / segment_size_);
+    }
+    uint64_t Position() const { return lap_ * capacity_ + head_; }
+    // Opens a new window once the current one is half used
+    void RefreshWindow();
+
+    GLBuffer   buffer_{BufferType::kCopyReadBuffer};
+    size_t     capacity_;
+    size_t     segment_size_;
+    size_t     head_{};
+    uint64_t   lap_{};
+    int        segment_{};  // the segment head_ is in
+    std::byte* mapped_{};
+
+    std::array<GLsync, kSegments> fences_{};
+    Stats                         stats_{};
+
+    std::atomic<std::shared_ptr<Window>> window_;
+    // Every window the ring has not reached again, oldest first
+    std::deque<std::shared_ptr<Window>> windows_;
+};
+}  // namespace pop::gfx
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "graphics/buffer_allocator.hpp"
+#include "graphics/stream_buffer.hpp"
+#include "graphics/vertex_buffers.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace pop::gfx {
+// One vertex buffer and VAO shared by every mesh with the same vertex
+// layout. A mesh owns a range of vertices in it and draws with the range
+// offset as its first vertex, so drawing many meshes needs a single VAO
+// and uploads never reallocate the driver's storage. Uploads go through a
+// StreamBuffer and are copied into place on the GPU.
+//
+// Everything except Free and Stage must be called on the render thread.
+// Free is thread safe so a range can be released wherever its owner is
+// destroyed, Stage so producers can fill the staging ring themselves.
+class VertexPool {
+   public:
+    using Range = BufferAllocator::Range;  // in vertices
+    struct Stats {
+        BufferAllocator::Stats vertices;
+        size_t                 grows;
+        StreamBuffer::Stats    uploads;
+    };
+    static constexpr size_t kStagingBytes = 8 << 20;
+
+    // stride is in bytes, initialVertices the starting capacity
+    VertexPool(std::vector<Attribute> attributes, GLsizei stride,
+               size_t initialVertices);
+
+    VertexPool(const VertexPool&)            = delete;
+    VertexPool& operator=(const VertexPool&) = delete;
+
+    // Grows the buffer when no free range is large enough
+    std::optional<Range> Allocate(size_t vertices);
+    // Writes range.size vertices of data into range
+    void Write(const Range& range, const void* data);
+    // Copies vertices of data into the staging ring for a later WriteStaged,
+    // nullopt when it does not fit right now
+    std::optional<StreamBuffer::Staged> Stage(const void* data,
+                                              size_t      vertices);
+    // Write from the staging ring, false when the staged copy is gone
+    bool WriteStaged(const Range& range, const StreamBuffer::Staged& staged);
+    void Free(const Range& range);
+    // Binds the shared VAO
+    void Bind();
+
+    GLsizei GetStride() const { return stride_; }
+    GLuint  GetVertexArrayId() const { return vao_.id(); }
+    Stats   GetStats() const;
+
+   private:
+    // Copies the contents into a buffer of at least minVertices on the GPU
+    void Grow(size_t minVertices);
+    void SetupVertexArray();
+
+    std::vector<Attribute> attributes_;
+    GLsizei                stride_;
+    VertexArray            vao_;
+    GLBuffer               vbo_{BufferType::kArrayBuffer};
+    StreamBuffer           staging_{kStagingBytes};
+
+    mutable std::mutex mutex_;  // guards allocator_ and grows_
+    BufferAllocator    allocator_;
+    size_t             grows_{};
+};
+}  // namespace pop::gfx
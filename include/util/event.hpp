@@ -0,0 +1,31 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+namespace pop::util {
+// Auto-reset event. Notify wakes one thread blocked in Wait, or lets the next
+// Wait return at once if nobody is waiting yet, so a signal is never lost.
+// Several Notify calls before a Wait collapse into one wake up.
+class Event {
+   public:
+    void Notify() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            signaled_ = true;
+        }
+        cv_.notify_one();
+    }
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return signaled_; });
+        signaled_ = false;
+    }
+
+   private:
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    bool                    signaled_{false};
+};
+}  // namespace pop::util
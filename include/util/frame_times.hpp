@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace pop::util {
+// Frame times of the last kCapacity frames, in milliseconds
+class FrameTimes {
+   public:
+    static constexpr size_t kCapacity = 1024;
+
+    struct Percentiles {
+        size_t frames;
+        float  p50, p95, p99, max;
+    };
+
+    void Add(float millis) {
+        if (samples_.size() < kCapacity) {
+            samples_.push_back(millis);
+        } else {
+            samples_[next_] = millis;
+        }
+        next_ = (next_ + 1) % kCapacity;
+    }
+    void Clear() {
+        samples_.clear();
+        next_ = 0;
+    }
+
+    Percentiles Get() const {
+        if (samples_.empty()) return {};
+        std::vector<float> sorted = samples_;
+        std::sort(sorted.begin(), sorted.end());
+        auto at = [&sorted](float p) {
+            return sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+        };
+        return {sorted.size(), at(0.50f), at(0.95f), at(0.99f), sorted.back()};
+    }
+
+   private:
+    std::vector<float> samples_;
+    size_t             next_{};
+};
+}  // namespace pop::util
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace pop::util {
+// Axis aligned box, min <= max on every axis
+struct AABB {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Clip space volume of a projection * view matrix as 6 inward facing
+// planes (Gribb & Hartmann). Pure math, no GL state involved.
+class Frustum {
+   public:
+    explicit Frustum(const glm::mat4& viewProjection) {
+        // glm is column major: row i of the matrix is m[0][i] .. m[3][i]
+        auto row = [&](int i) {
+            return glm::vec4{viewProjection[0][i], viewProjection[1][i],
+                             viewProjection[2][i], viewProjection[3][i]};
+        };
+        const glm::vec4 x = row(0), y = row(1), z = row(2), w = row(3);
+        const glm::vec4 planes[] = {w + x, w - x, w + y, w - y, w + z, w - z};
+        for (const auto& plane : planes) {
+            float length = glm::length(glm::vec3{plane});
+            // An infinite far plane degenerates to a zero normal and never
+            // rejects anything
+            if (length < kMinNormalLength) continue;
+            planes_[plane_count_++] = plane / length;
+        }
+    }
+
+    // Conservative: boxes crossing a corner of the frustum outside of it
+    // may still be reported as visible, never the other way around
+    bool Intersects(const AABB& box) const {
+        for (int i = 0; i < plane_count_; i++) {
+            const glm::vec4& plane = planes_[i];
+            // The corner farthest along the plane normal
+            glm::vec3 corner{plane.x >= 0 ? box.max.x : box.min.x,
+                             plane.y >= 0 ? box.max.y : box.min.y,
+                             plane.z >= 0 ? box.max.z : box.min.z};
+            if (glm::dot(glm::vec3{plane}, corner) + plane.w < 0) return false;
+        }
+        return true;
+    }
+    int PlaneCount() const { return plane_count_; }
+
+   private:
+    static constexpr float kMinNormalLength = 1e-5f;
+
+    std::array<glm::vec4, 6> planes_{};
+    int                      plane_count_{};
+};
+}  // namespace pop::util
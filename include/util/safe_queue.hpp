@@ -1,8 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <queue>
 #include <mutex>
 #include <optional>
+#include <vector>
 
 namespace pop::util {
 // Thread Safe Non blocking queue
@@ -31,6 +33,18 @@ class CmdQueue {
         return val;
     }
 
+    // Pops up to max elements under a single lock, oldest first
+    std::vector<T> try_pop_many(size_t max) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<T>              vals;
+        vals.reserve(std::min(max, m_queue.size()));
+        while (!m_queue.empty() && vals.size() < max) {
+            vals.push_back(std::move(m_queue.front()));
+            m_queue.pop();
+        }
+        return vals;
+    }
+
     bool empty() const {
         std::lock_guard<std::mutex> lock(m_mutex);
         return m_queue.empty();
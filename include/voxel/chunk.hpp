@@ -8,11 +8,18 @@
 #include "graphics/rendertypes.hpp"
 #include "graphics/shader.hpp"
 #include "graphics/vertex_buffers.hpp"
+#include "graphics/vertex_pool.hpp"
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <span>
 #include <vector>
 namespace pop::voxel {
+namespace terrain {
+struct ColumnCache;
+}
 
 class Voxel {
    public:
@@ -50,8 +57,27 @@ struct FaceGeometry {
 
     static constexpr const float* GetFace(pop::direction faceDirection);
 };
+// Vertices of one chunk mesh. Never changed once published, so the render
+// thread can read it while the next version is being built.
+struct ChunkMesh {
+    std::vector<float> vertices;
+    uint64_t           version;
+    // The same vertices in the pool's staging ring, written by the mesher
+    std::optional<gfx::StreamBuffer::Staged> staged;
+};
+
+// The mesher hands each new mesh over with Publish; the render thread takes
+// the latest one in Upload. Versions replaced before their upload are never
+// uploaded.
 class ChunkRenderable : public Renderable {
    public:
+    // position xyz, face uv, face, block type
+    static constexpr int kFloatsPerVertex = 7;
+    // Layout of the shared VertexPool every chunk mesh is uploaded into
+    static std::vector<gfx::Attribute> VertexAttributes();
+    static constexpr GLsizei           kVertexStride =
+        kFloatsPerVertex * sizeof(float);
+
     ChunkRenderable(gfx::ShaderHandle shaderId, bool isTransparent = false);
     ~ChunkRenderable();
 
@@ -59,33 +85,42 @@ class ChunkRenderable : public Renderable {
     void              Draw(gfx::ShaderProgram* const shader_program) override;
     gfx::ShaderHandle GetShaderProgId() const override;
     bool              IsTransparent() const override { return is_transparent_; }
+    std::optional<util::AABB> GetWorldBounds() const override;
+    bool                      AddToBatch(gfx::DrawBatch& batch) override;
+    GLuint                    GetTextureId() const override;
+    GLuint                    GetVertexArrayId() const override {
+        return pool_ ? pool_->GetVertexArrayId() : 0;
+    }
+    size_t GetUploadSize() const override;
 
     void AddTexture(std::shared_ptr<gfx::rtypes::TextureBinding> texture);
-    void AddAttribute(const gfx::Attribute& attribute);
-    void AddVertexData(const std::vector<float>& data);
+    // Replaces any mesh still waiting for its upload. One mesher at a time.
+    // Also stages the vertices in the vertex pool when there is room.
+    void Publish(std::vector<float>&& vertices);
     void SetChunkOffset(const glm::ivec3& offset) { chunk_offset_ = offset; }
-    void clearData() {
-        vertex_data_->clear();
-        attributes_.clear();
-        textures_.clear();
-        // num_vertices_ = 0;
+    // Must be set before the first Publish
+    void SetVertexPool(std::shared_ptr<gfx::VertexPool> pool) {
+        pool_ = std::move(pool);
     }
-    std::vector<float>& VertexData() { return *vertex_data_; }
+    // Published meshes replaced before their upload, all chunks
+    static uint64_t GetSupersededMeshes() { return superseded_meshes_; }
 
    private:
-    bool              first_upload_{true};
     bool              is_transparent_;
-    gfx::VertexArray  vao_{true};
-    gfx::GLBuffer     vbo_{gfx::BufferType::kArrayBuffer, true};
-    gfx::GLBuffer     ebo_{gfx::BufferType::kElementArrayBuffer, true};
     gfx::ShaderHandle shader_id_;
+    // Where the uploaded vertices live in pool_
+    std::shared_ptr<gfx::VertexPool>       pool_;
+    std::optional<gfx::VertexPool::Range> range_;
     int               num_vertices_{};
     std::vector<std::shared_ptr<gfx::rtypes::TextureBinding>> textures_;
 
     glm::ivec3 chunk_offset_{};
 
-    std::unique_ptr<std::vector<float>> vertex_data_;
-    std::vector<gfx::Attribute>         attributes_;
+    std::atomic<std::shared_ptr<const ChunkMesh>> pending_mesh_;
+    uint64_t                                      published_version_{};
+    uint64_t                                      uploaded_version_{};
+
+    static inline std::atomic<uint64_t> superseded_meshes_{0};
 };
 
 class Chunk {
@@ -96,43 +131,103 @@ class Chunk {
     constexpr static int kSize_y         = kBaseHeight + kVariableHeight;
     constexpr static int kWaterBaseline  = kBaseHeight - 2;
     constexpr static int kSize_z         = 16;
+    constexpr static int kVolume         = kSize_x * kSize_y * kSize_z;
     constexpr static int kNumMeshes =
         static_cast<int>(gfx::rtypes::MeshType::kMeshCount);
     // top and bottom direction should be nullptr.
     using NeighborArray = std::array<Chunk*, 6>;
+    // World generation stages, see terrain::WorldGenPipeline
+    enum class GenStage : uint8_t { kEmpty, kDensity, kSurface, kDecorated };
+    // Streaming lifecycle after generation, driven by ChunkManager: a chunk
+    // is meshed once, when all four of its neighbors exist
+    enum class MeshState : uint8_t {
+        kGenerated,
+        kNeighborsReady,  // queued for its first mesh
+        kMeshed,
+        kUploaded  // renderables handed to the engine
+    };
 
-    constexpr static int Index(int x, int y, int z);
+    // Columns are contiguous: y is the fastest moving axis
+    constexpr static int Index(int x, int y, int z) {
+        return y + kSize_y * (x + kSize_x * z);
+    }
+    // Index of a cell of a low detail chunk, each cell covers lod^3 voxels.
+    // Same as Index for lod 1.
+    constexpr static int LodIndex(int cx, int cy, int cz, int lod) {
+        return cy + (kSize_y / lod) * (cx + (kSize_x / lod) * cz);
+    }
 
-    Chunk(glm::ivec3 chunkOffset);
+    // Starts out as all air, see terrain::WorldGenPipeline::Generate.
+    // lod (1, 2, 4 or 8) is the edge length in voxels of one stored cell;
+    // memory and generation cost shrink with its cube.
+    Chunk(glm::ivec3 chunkOffset, int lod = 1);
     ~Chunk() = default;
 
+    int GetLod() const { return lod_; }
+    // Cells per axis at this chunk's level of detail
+    int CellsX() const { return kSize_x / lod_; }
+    int CellsY() const { return kSize_y / lod_; }
+    int CellsZ() const { return kSize_z / lod_; }
+
+    std::span<Voxel>       Voxels();
+    std::span<const Voxel> Voxels() const;
+    const glm::ivec3&      GetOffset() const { return chunk_offset_; }
+    GenStage               GetStage() const { return stage_; }
+    void                   SetStage(GenStage stage) { stage_ = stage; }
+    MeshState              GetMeshState() const { return mesh_state_; }
+    void SetMeshState(MeshState state) { mesh_state_ = state; }
+    // Set by the density stage, nullptr before that and for low detail
+    // chunks
+    const std::shared_ptr<const terrain::ColumnCache>& GetColumns() const {
+        return columns_;
+    }
+    void SetColumns(std::shared_ptr<const terrain::ColumnCache> columns) {
+        columns_ = std::move(columns);
+    }
+
     void        BreakBlock(const glm::ivec3& coord);
     void        AddBlock(const glm::ivec3& coord, Voxel::Type vtype);
     Voxel::Type GetVoxelAtCoord(const glm::ivec3& coord) const;
     void        GenerateMesh();
-    // call to regenerate the mesh on existing chunkrenderable
+    // Publishes a new version of every mesh to the existing renderables,
+    // which may be uploading the previous one meanwhile
     void ReGenerate();
     void SetNeighbors(const NeighborArray& neighbors) {
         neighbors_ = neighbors;
     }
     void SetShader(gfx::rtypes::MeshType shaderMeshType,
                    gfx::ShaderHandle     shaderHandle);
+    // Handed to the renderables GenerateMesh creates
+    void SetVertexPool(std::shared_ptr<gfx::VertexPool> pool) {
+        vertex_pool_ = std::move(pool);
+    }
 
     std::shared_ptr<ChunkRenderable> GetRenderable(
         gfx::rtypes::MeshType mtype) const;
 
    private:
+    // x, y, z are in cells, see GetLod
     void GenerateVoxel(int x, int y, int z, Voxel::Type vtype,
-                       const std::shared_ptr<ChunkRenderable>& mesh);
+                       std::vector<float>& verts) const;
+    // Builds every mesh and publishes it to its renderable
     void GenerateRenderable();
-    void PopulateFromHeightMap();
     bool ShouldDrawFace(Voxel::Type current, Voxel::Type neighbor) const;
 
+    // Full detail voxel coordinates to an index into voxel_data_
+    int         LocalIndex(int x, int y, int z) const {
+        return lod_ == 1 ? Index(x, y, z)
+                         : LodIndex(x / lod_, y / lod_, z / lod_, lod_);
+    }
     Voxel::Type GetLocalVoxelType(int x, int y, int z) const;
     Voxel::Type GetVoxelType(int x, int y, int z) const;
 
    private:
     glm::ivec3 chunk_offset_{};
+    int        lod_{1};
+    GenStage   stage_{GenStage::kEmpty};
+    MeshState  mesh_state_{MeshState::kGenerated};
+
+    std::shared_ptr<const terrain::ColumnCache> columns_{};
 
     std::unique_ptr<Voxel[]> voxel_data_{};
     NeighborArray            neighbors_{};
@@ -140,6 +235,7 @@ class Chunk {
 
     std::array<gfx::ShaderHandle, kNumMeshes>                shader_ids_{};
     std::array<std::shared_ptr<ChunkRenderable>, kNumMeshes> meshes_{};
+    std::shared_ptr<gfx::VertexPool>                         vertex_pool_{};
 };
 // 6 vertices * (3 pos + 2 uv) = 30 floats per face
 inline constexpr float kTopFace[] = {
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "glm/vec3.hpp"
+#include "util/math.hpp"
+#include "voxel/chunk.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+namespace pop::voxel {
+struct ChunkCoord {
+    int        x, z;
+    ChunkCoord operator+(const ChunkCoord& other) const {
+        return ChunkCoord{x + other.x, z + other.z};
+    }
+    ChunkCoord operator-(const ChunkCoord& other) const {
+        return ChunkCoord{x - other.x, z - other.z};
+    }
+    bool operator==(const ChunkCoord& other) const noexcept {
+        return x == other.x && z == other.z;
+    }
+};
+
+inline constexpr ChunkCoord WorldToChunkCoord(const glm::ivec3& worldPoint) {
+    return {static_cast<int>(
+                std::floor(static_cast<float>(worldPoint.x) / Chunk::kSize_x)),
+            static_cast<int>(
+                std::floor(static_cast<float>(worldPoint.z) / Chunk::kSize_z))};
+}
+inline constexpr glm::ivec3 WorldToChunkLocal(const glm::ivec3& worldPoint) {
+    return {util::PositiveMod(worldPoint.x, Chunk::kSize_x),
+            util::PositiveMod(worldPoint.y, Chunk::kSize_y),
+            util::PositiveMod(worldPoint.z, Chunk::kSize_z)};
+}
+inline glm::ivec3 ChunkToOffset(const ChunkCoord& coord) {
+    return {coord.x * Chunk::kSize_x, 0, coord.z * Chunk::kSize_z};
+}
+// Chebyshev distance: the square "radius" at which b is seen from a
+inline int ChunkDistance(const ChunkCoord& a, const ChunkCoord& b) {
+    return std::max(std::abs(a.x - b.x), std::abs(a.z - b.z));
+}
+
+// Calls fn(coord) for every coord within toRadius of to but not within
+// fromRadius of from, i.e. the strip a square gains when it moves and/or
+// grows. Visits O(toRadius) rows plus the cells it reports, so a one chunk
+// step costs O(radius) and a jump further than the square is simply the
+// whole new square.
+template <typename Fn>
+void ForEachSquareDifference(const ChunkCoord& to, int toRadius,
+                             const ChunkCoord& from, int fromRadius, Fn&& fn) {
+    for (int x = to.x - toRadius; x <= to.x + toRadius; x++) {
+        int zBegin = to.z - toRadius, zEnd = to.z + toRadius;
+        if (std::abs(x - from.x) > fromRadius) {
+            for (int z = zBegin; z <= zEnd; z++) fn(ChunkCoord{x, z});
+            continue;
+        }
+        // This row overlaps the old square: only the ends stick out of it
+        for (int z = zBegin; z <= std::min(zEnd, from.z - fromRadius - 1); z++)
+            fn(ChunkCoord{x, z});
+        for (int z = std::max(zBegin, from.z + fromRadius + 1); z <= zEnd; z++)
+            fn(ChunkCoord{x, z});
+    }
+}
+template <typename Fn>
+void ForEachSquareDifference(const ChunkCoord& to, const ChunkCoord& from,
+                             int radius, Fn&& fn) {
+    ForEachSquareDifference(to, radius, from, radius, std::forward<Fn>(fn));
+}
+
+struct ChunkCoordHash {
+    size_t operator()(const ChunkCoord& c) const noexcept {
+        // Both halves go through a full 64 bit mix: neighboring coords land
+        // in unrelated buckets instead of clustering like x ^ (z << 1)
+        uint64_t h = (static_cast<uint64_t>(static_cast<uint32_t>(c.x)) << 32) |
+                     static_cast<uint32_t>(c.z);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+};
+};  // namespace pop::voxel
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "voxel/chunk.hpp"
+#include "voxel/chunk_coord.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace pop::voxel {
+
+// Loaded chunks in a fixed (2 * radius + 1)^2 toroidal grid: a chunk lives
+// in the slot (x mod size, z mod size). Any window of size x size chunks maps
+// to distinct slots, so as long as every loaded chunk is within radius of
+// one center no two of them collide. Lookups, inserts and evictions are an
+// index computation and one coord compare: no hashing, no node allocations.
+class ChunkGrid {
+   public:
+    explicit ChunkGrid(int radius);
+
+    int GetRadius() const { return radius_; }
+    int GetSize() const { return size_; }
+
+    Chunk* Find(const ChunkCoord& coord) const {
+        const auto& slot = slots_[SlotIndex(coord)];
+        return slot.chunk && slot.coord == coord ? slot.chunk.get() : nullptr;
+    }
+    bool Contains(const ChunkCoord& coord) const { return Find(coord); }
+
+    // Replaces a chunk with the same coord. The slot must not hold another
+    // coord, see the class comment.
+    void Insert(const ChunkCoord& coord, std::unique_ptr<Chunk> chunk);
+    // Returns the removed chunk, nullptr if coord was not loaded
+    std::unique_ptr<Chunk> Erase(const ChunkCoord& coord);
+
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (const auto& slot : slots_)
+            if (slot.chunk) fn(slot.coord, *slot.chunk);
+    }
+
+   private:
+    struct Slot {
+        ChunkCoord             coord{};
+        std::unique_ptr<Chunk> chunk;
+    };
+
+    size_t SlotIndex(const ChunkCoord& coord) const {
+        return static_cast<size_t>(util::PositiveMod(coord.x, size_) +
+                                   size_ * util::PositiveMod(coord.z, size_));
+    }
+
+    int               radius_, size_;
+    std::vector<Slot> slots_;
+};
+}  // namespace pop::voxel
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "glm/vec3.hpp"
+#include "voxel/chunk_coord.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace pop::voxel {
+
+// Lower is more urgent: the distance from the camera to the chunk center on
+// the xz plane, stretched up to 1 + kBehindPenalty times for chunks behind
+// the camera. Chunks the camera is in or right next to always come first.
+float ChunkPriority(const ChunkCoord& coord, const glm::vec3& cameraPos,
+                    const glm::vec3& forward);
+
+// Min-heap of chunk coords by ChunkPriority. The keys move with the camera,
+// so the heap is rebuilt from the owner's pending set once per tick instead
+// of being kept sorted across ticks.
+class ChunkPriorityQueue {
+   public:
+    static constexpr float kBehindPenalty = 1.0f;
+
+    void Rebuild(const std::unordered_set<ChunkCoord, ChunkCoordHash>& coords,
+                 const glm::vec3& cameraPos, const glm::vec3& forward);
+    bool       Empty() const { return heap_.empty(); }
+    size_t     Size() const { return heap_.size(); }
+    ChunkCoord Pop();
+
+   private:
+    std::vector<std::pair<float, ChunkCoord>> heap_;
+};
+
+// Caps the work of one ChunkManager tick: stops after maxChunks chunks or
+// maxMillis, whichever comes first.
+struct TickBudget {
+    int   maxChunks = 8;
+    float maxMillis = 8.0f;
+};
+
+// Tracks one tick against a TickBudget. At least one chunk is always
+// allowed so streaming cannot stall on a single slow chunk.
+class BudgetScope {
+   public:
+    explicit BudgetScope(const TickBudget& budget)
+        : budget_{budget}, start_{std::chrono::steady_clock::now()} {}
+
+    bool Exhausted() const {
+        if (done_ == 0) return false;
+        if (done_ >= budget_.maxChunks) return true;
+        return std::chrono::duration<float, std::milli>(
+                   std::chrono::steady_clock::now() - start_)
+                   .count() >= budget_.maxMillis;
+    }
+    void Count() { done_++; }
+    int  Remaining() const { return std::max(budget_.maxChunks - done_, 1); }
+
+   private:
+    TickBudget                            budget_;
+    std::chrono::steady_clock::time_point start_;
+    int                                   done_{};
+};
+}  // namespace pop::voxel
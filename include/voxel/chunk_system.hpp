@@ -3,52 +3,32 @@
 #include "glm/common.hpp"
 #include "graphics/camera.hpp"
 #include "core/engine.hpp"
+#include "core/job_system.hpp"
+#include "util/event.hpp"
 #include "util/math.hpp"
 #include "util/safe_queue.hpp"
 #include "voxel/chunk.hpp"
+#include "voxel/chunk_coord.hpp"
+#include "voxel/chunk_grid.hpp"
+#include "voxel/chunk_queue.hpp"
+#include "voxel/retained_chunks.hpp"
+#include "voxel/terrain_generator.hpp"
+#include "voxel/world_gen.hpp"
 #include "gl/gl_types.hpp"
 #include "glm/fwd.hpp"
 #include "graphics/rendertypes.hpp"
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <span>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace pop::voxel {
-struct ChunkCoord {
-    int        x, z;
-    ChunkCoord operator+(const ChunkCoord& other) const {
-        return ChunkCoord{x + other.x, z + other.z};
-    }
-    ChunkCoord operator-(const ChunkCoord& other) const {
-        return ChunkCoord{x - other.x, z - other.z};
-    }
-    bool operator==(const ChunkCoord& other) const noexcept {
-        return x == other.x && z == other.z;
-    }
-};
-
-inline constexpr ChunkCoord WorldToChunkCoord(const glm::ivec3& worldPoint) {
-    return {static_cast<int>(
-                std::floor(static_cast<float>(worldPoint.x) / Chunk::kSize_x)),
-            static_cast<int>(
-                std::floor(static_cast<float>(worldPoint.z) / Chunk::kSize_z))};
-}
-inline constexpr glm::ivec3 WorldToChunkLocal(const glm::ivec3& worldPoint) {
-    return {util::PositiveMod(worldPoint.x, Chunk::kSize_x),
-            util::PositiveMod(worldPoint.y, Chunk::kSize_y),
-            util::PositiveMod(worldPoint.z, Chunk::kSize_z)};
-}
-inline glm::ivec3 ChunkToOffset(const ChunkCoord& coord) {
-    return {coord.x * Chunk::kSize_x, 0, coord.z * Chunk::kSize_z};
-}
-struct ChunkCoordHash {
-    size_t operator()(const ChunkCoord& c) const noexcept {
-        size_t h1 = std::hash<int>{}(c.x);
-        size_t h2 = std::hash<int>{}(c.z);
-        return h1 ^ (h2 << 1);
-    }
-};
 class ChunkManager {
    public:
     struct ChunkBlockCmd {
@@ -56,7 +36,35 @@ class ChunkManager {
         glm::vec3   direction;
         Voxel::Type voxelToSet;
     };
-    static constexpr int RenderDistance = 8;
+    // Render distance in chunks (chebyshev), see SetRenderDistance
+    static constexpr int kMinRenderDistance     = 2;
+    static constexpr int kMaxRenderDistance     = 32;
+    static constexpr int kDefaultRenderDistance = 16;
+    // Loaded chunks are only dropped kUnloadMargin chunks past the render
+    // distance, so moving back and forth over a border does not unload and
+    // reload a ring every time
+    static constexpr int kUnloadMargin = 2;
+    // Chunks are generated kLoadMargin rings past the render distance so
+    // every meshed chunk has all its neighbors
+    static constexpr int kLoadMargin = 1;
+    // Nothing loaded is farther out, the radius of the chunk grid
+    static constexpr int kMaxUnloadDistance =
+        kMaxRenderDistance + kLoadMargin + kUnloadMargin;
+    // Block edits applied per pass of the chunk thread
+    static constexpr size_t kMaxCommandsPerTick = 256;
+    // Dropped chunks kept with their meshes in case the camera comes back:
+    // a few strips of the largest area
+    static constexpr size_t kRetainedChunks = 4 * (2 * kMaxUnloadDistance + 1);
+    // Chunks at most maxDistance chunks (chebyshev) away from the camera are
+    // generated with one voxel per lod^3 block. Bands are sorted by distance
+    // and the last one covers the largest render distance.
+    struct LodBand {
+        int maxDistance;
+        int lod;
+    };
+    static constexpr LodBand kLodBands[] = {
+        {4, 1}, {8, 2}, {12, 4}, {kMaxRenderDistance, 8}};
+    static int LodForDistance(int distance);
 
     ChunkManager(const gfx::FlyCam* playerCam);
     ~ChunkManager() = default;
@@ -64,36 +72,183 @@ class ChunkManager {
     void Run(core::Engine& engine);
     void SetShader(gfx::rtypes::MeshType meshType, gfx::ShaderHandle handle);
     void SetTexture(std::shared_ptr<gfx::rtypes::TextureBinding> texture);
+    // Pool every chunk mesh is uploaded into, with the
+    // ChunkRenderable::VertexAttributes layout. Must be called before Run.
+    void SetVertexPool(std::shared_ptr<gfx::VertexPool> pool) {
+        vertex_pool_ = std::move(pool);
+    }
+    // Must be called before Run, defaults to the 3D DensityGenerator
+    void SetGenerator(std::unique_ptr<terrain::Generator> generator);
     void AddChunkBlockCmd(const ChunkBlockCmd& cmd);
+    // Call from the render thread after the camera moved. Wakes the chunk
+    // thread when the camera entered another chunk.
+    void OnCameraMoved(const glm::vec3& position);
+    // Wakes the chunk thread, e.g. when background work finished
+    void Wake() { wake_.Notify(); }
+    // Makes Run return. Call once the engine stopped.
+    void Stop();
+
+    core::JobSystem::Stats GetJobStats() const { return jobs_.GetStats(); }
+    // Per tick limits for generating and for meshing queued chunks. Must be
+    // called before Run. Generation submits maxChunks at once and skips the
+    // ones not started yet once maxMillis is up.
+    void SetGenerationBudget(const TickBudget& budget) {
+        generation_budget_ = budget;
+    }
+    void SetMeshBudget(const TickBudget& budget) { mesh_budget_ = budget; }
+    // Per tick limit for remeshing chunks changed by block edits
+    void SetDirtyBudget(const TickBudget& budget) { dirty_budget_ = budget; }
+
+    // Thread safe. Clamped to [kMinRenderDistance, kMaxRenderDistance]; the
+    // chunk thread applies it incrementally on its next pass.
+    void SetRenderDistance(int distance);
+    int  GetRenderDistance() const { return requested_distance_; }
+    // Share of the last second the chunk thread spent working rather than
+    // waiting for events, in [0, 1]
+    float GetUtilization() const { return utilization_; }
+    // Remeshes skipped because a neighbor arrived after a chunk was meshed
+    // with all its neighbors already in place
+    uint64_t GetAvoidedRemeshes() const { return avoided_remeshes_; }
+
+    // Chunk work dropped because the camera left the chunk's range while it
+    // was in flight. cancelled*: dropped before that stage ran, wasted*:
+    // results thrown away after the work was done.
+    struct CancelStats {
+        uint64_t cancelledGenerations, cancelledMeshes, cancelledUploads;
+        uint64_t wastedGenerations, wastedMeshes;
+    };
+    CancelStats GetCancelStats() const;
 
    private:
+    // Taken when chunk work is picked, for the area of area_epoch_. The work
+    // is dropped at its next stage once the camera entered another chunk
+    // and coord is out of range of it; the chunk goes back to the set it
+    // was picked from, where the next pass drops or redoes it.
+    struct WorkToken {
+        ChunkCoord coord;
+        uint32_t   epoch;
+    };
+    WorkToken MakeToken(const ChunkCoord& coord) const {
+        return {coord, area_epoch_};
+    }
+    // Thread safe
+    bool IsCancelled(const WorkToken& token, int distance) const;
+
     void BreakBlock(glm::vec3 position, glm::vec3 dir);
+    // Applies at most kMaxCommandsPerTick queued edits
     void ProcessCommands();
+    // Remeshes the most urgent dirty chunks within dirty_budget_
     void ProcessDirtyChunks(core::Engine& engine);
+    // Meshes the most urgent new chunks within mesh_budget_
     void ProcessNewChunks(core::Engine& engine);
+    // Pops queued by ChunkPriority and meshes the chunks accept returns true
+    // for, in parallel batches, until budget runs out. The rest stays queued.
+    template <typename Accept>
+    void MeshByPriority(std::unordered_set<ChunkCoord, ChunkCoordHash>& queued,
+                        const TickBudget& budget, bool remesh,
+                        core::Engine& engine, Accept accept);
+    // Queues the whole area around center, nothing may be loaded yet
+    void LoadArea(const ChunkCoord& center);
+    // Moves the area to center: retires the strip that left the unload
+    // distance, queues the strip that entered the load distance and the
+    // chunks that crossed into another LOD band.
+    // Costs O(render distance) per chunk the camera moved.
+    void MoveArea(const ChunkCoord& center, core::Engine& engine);
+    // Grows or shrinks the area around center_ by the ring in between
+    void ResizeArea(int distance, core::Engine& engine);
+    int LoadDistance() const { return render_distance_ + kLoadMargin; }
+    int UnloadDistance() const { return LoadDistance() + kUnloadMargin; }
+    // Generates the most urgent queued chunks within generation_budget_,
+    // and meshes the chunks they complete as soon as that is safe
+    void GeneratePending(core::Engine& engine);
     void UploadChunkToEngine(const ChunkCoord& coord, core::Engine& engine,
                              bool Update = false);
     // WARN:Doesn't erase from the loaded_chunks
     void UnLoadChunk(const ChunkCoord& chunkCoord, core::Engine& engine);
+    // Unloads a chunk that left the unload distance into retained_
+    void RetireChunk(const ChunkCoord& coord, core::Engine& engine);
+    // Puts a retained chunk back without generating or meshing it again
+    void RestoreChunk(const ChunkCoord& coord, std::unique_ptr<Chunk> chunk,
+                      core::Engine& engine);
+    // Hands the renderables of a chunk about to be destroyed to the render
+    // thread, so their GL objects are deleted where the context lives
+    void ReleaseChunk(const Chunk& chunk, core::Engine& engine);
     // Helper to get raw ptr from the map
     Chunk* GetRawChunkPtr(const ChunkCoord& coord);
 
-    std::unique_ptr<Chunk> GenerateChunk(const ChunkCoord& chunkCoord);
+    // Runs the chunk local stages (density and surface)
+    std::unique_ptr<Chunk> GenerateChunk(const ChunkCoord& chunkCoord,
+                                         int               lod = 1);
+    // Decoration stage for freshly generated chunks, then hands the writes
+    // they buffered to whichever of their neighbors are loaded
+    void DecorateChunks(const std::vector<ChunkCoord>& coords);
 
     void LinkChunkNeighbors(const ChunkCoord& coord);
-    void LinkAndMesh(const ChunkCoord& coord, core::Engine& engine);
+    // A mesh job in flight. dropped is set by the job when it was
+    // cancelled before running.
+    struct MeshJob {
+        ChunkCoord      coord;
+        bool            remesh;
+        bool            dropped{};
+        core::JobHandle handle;
+    };
+    // Links coord to its neighbors and submits its mesh job, to run after
+    // dependencies. Nothing may write into coord or its neighbors until the
+    // job is finished.
+    void SubmitMesh(std::deque<MeshJob>& meshing, const ChunkCoord& coord,
+                    bool remesh,
+                    std::span<const core::JobHandle> dependencies = {});
+    // Waits for the jobs and uploads what was not cancelled
+    void FinishMeshes(std::deque<MeshJob>& meshing, core::Engine& engine);
+    // Meshes (or remeshes) coords on the job system and uploads them
+    void MeshChunks(const std::vector<ChunkCoord>& coords, bool remesh,
+                    core::Engine& engine);
     void MarkDirty(const ChunkCoord& coord, bool markAll = true,
                    const glm::ivec3& blockUpdated = {0, 0, 0});
 
-    void InitialLoad(core::Engine& engine);
     bool IsChunkLoaded(const ChunkCoord& chunkCoord);
+    // Within the render distance with all 4 neighbors loaded
+    bool IsMeshable(const ChunkCoord& coord);
+    // Queues a kGenerated chunk for its first mesh once it is meshable
+    void QueueIfMeshable(const ChunkCoord& coord);
+    // A chunk was inserted (replaced: over one at another LOD). Queues it
+    // and any neighbor it completed; meshed neighbors only need a remesh
+    // when the chunk replaced another one.
+    void OnChunkArrived(const ChunkCoord& coord, bool replaced);
 
    private:
     util::CmdQueue<ChunkBlockCmd>                  chunkCmdQ{};
+    // new_chunks_: neighbors ready, waiting for their first mesh
     std::unordered_set<ChunkCoord, ChunkCoordHash> dirty_chunks_, new_chunks_;
-    std::unordered_map<ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash>
-                                                 loaded_chunks_;
+    // In range but not generated yet, or loaded at the wrong LOD
+    std::unordered_set<ChunkCoord, ChunkCoordHash> pending_chunks_;
+    ChunkCoord                                     center_{};
+    int                render_distance_{kDefaultRenderDistance};
+    std::atomic<int>   requested_distance_{kDefaultRenderDistance};
+    std::atomic<float> utilization_{0.0f};
+    std::atomic<uint64_t> avoided_remeshes_{0};
+    ChunkPriorityQueue                             queue_;
+    // Generation and meshing jobs; also runs jobs while the chunk thread
+    // waits for them
+    core::JobSystem jobs_;
+    TickBudget      generation_budget_{32, 8.0f}, mesh_budget_{32, 6.0f},
+        dirty_budget_{16, 4.0f};
+    // The chunk thread sleeps on wake_ whenever it has nothing queued
+    util::Event       wake_;
+    std::atomic<bool> stop_{false};
+    ChunkCoord        notified_chunk_{};  // render thread only
+    bool              has_notified_{false};
+    // Latest camera chunk, bumping camera_epoch_ on every change
+    std::atomic<ChunkCoord> camera_chunk_{};
+    std::atomic<uint32_t>   camera_epoch_{0};
+    uint32_t                area_epoch_{0};  // camera_epoch_ of center_
+    std::atomic<uint64_t>   cancelled_generations_{0}, cancelled_meshes_{0},
+        cancelled_uploads_{0}, wasted_generations_{0}, wasted_meshes_{0};
+    ChunkGrid                                    loaded_chunks_;
+    RetainedChunkCache                           retained_;
     std::shared_ptr<gfx::rtypes::TextureBinding> tex_;
+    std::shared_ptr<gfx::VertexPool>             vertex_pool_;
+    terrain::WorldGenPipeline                    pipeline_;
     const gfx::FlyCam*                           player_cam_;
     std::array<gfx::ShaderHandle,
                static_cast<size_t>(gfx::rtypes::MeshType::kMeshCount)>
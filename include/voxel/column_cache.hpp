@@ -0,0 +1,59 @@
+#pragma once
+
+#include "voxel/chunk.hpp"
+#include "voxel/chunk_coord.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace pop::voxel::terrain {
+
+// Per (x, z) column attributes of one chunk, written by FillColumns and the
+// density stage. Later stages of the same chunk only read them.
+struct ColumnCache {
+    static constexpr int kColumns = Chunk::kSize_x * Chunk::kSize_z;
+    static constexpr int Index(int x, int z) { return x + Chunk::kSize_x * z; }
+
+    // Surface height predicted by the 2D noise (world y). Only filled by
+    // generators that read it, see Generator::FillColumns.
+    std::array<float, kColumns> height{};
+    // Highest solid voxel after the density stage, -1 for an empty column
+    std::array<int16_t, kColumns> surface{};
+    // Lowest air voxel after the density stage, kSize_y for a full column
+    std::array<int16_t, kColumns> lowestAir{};
+    // surface and lowestAir hold an earlier density stage of this chunk:
+    // only the voxels between them still need the noise
+    bool resolved{};
+
+    int SurfaceAt(int x, int z) const { return surface[Index(x, z)]; }
+};
+
+// Bounded, thread safe chunk -> ColumnCache map. Keeps recently unloaded
+// chunks around so generating them again skips the 2D noise and most of the
+// 3D noise.
+class ColumnCacheStore {
+   public:
+    explicit ColumnCacheStore(size_t capacity = 4096);
+
+    std::shared_ptr<const ColumnCache> Find(const ChunkCoord& coord);
+    void Insert(const ChunkCoord&                  coord,
+                std::shared_ptr<const ColumnCache> columns);
+    void Clear();
+
+   private:
+    struct Entry {
+        std::shared_ptr<const ColumnCache> columns;
+        std::list<ChunkCoord>::iterator    lru;
+    };
+
+    size_t                                                capacity_;
+    std::mutex                                            mutex_;
+    std::list<ChunkCoord>                                 lru_;  // newest first
+    std::unordered_map<ChunkCoord, Entry, ChunkCoordHash> entries_;
+};
+}  // namespace pop::voxel::terrain
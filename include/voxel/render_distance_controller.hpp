@@ -0,0 +1,38 @@
+#pragma once
+
+namespace pop::voxel {
+
+// Picks a render distance that holds a target frame time without outrunning
+// the chunk thread. Feed it every frame; it moves the distance one chunk at
+// a time, at most once per cooldown, and only when the smoothed frame time
+// is clearly off target, so it does not oscillate around the limit.
+class RenderDistanceController {
+   public:
+    struct Settings {
+        float targetFrameMs  = 1000.0f / 60.0f;
+        int   minDistance    = 4;
+        int   maxDistance    = 32;
+        // Above this the chunk thread is not allowed to get more work, and
+        // if it stays there for saturatedSec the distance shrinks
+        float maxUtilization = 0.9f;
+        float saturatedSec   = 3.0f;
+        float cooldownSec    = 1.0f;
+    };
+
+    RenderDistanceController() = default;
+    explicit RenderDistanceController(const Settings& settings)
+        : settings_{settings} {}
+
+    // frameSec is the last frame's duration, utilization the chunk thread's
+    // busy share. Returns the distance to use from now on.
+    int Update(float frameSec, float utilization, int currentDistance);
+
+    float GetSmoothedFrameMs() const { return smoothed_ms_; }
+
+   private:
+    Settings settings_{};
+    float    smoothed_ms_{0.0f};
+    float    since_change_{0.0f};
+    float    saturated_for_{0.0f};
+};
+}  // namespace pop::voxel
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "voxel/chunk.hpp"
+#include "voxel/chunk_coord.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace pop::voxel {
+
+// Bounded LRU of chunks that left the unload radius, kept together with
+// their meshes (and the GPU buffers behind them) so coming back only has to
+// hand the renderables to the engine again. Chunk thread only.
+class RetainedChunkCache {
+   public:
+    explicit RetainedChunkCache(size_t capacity);
+
+    // Returns the least recently retained chunk if this one pushed it out
+    std::unique_ptr<Chunk> Put(const ChunkCoord&      coord,
+                               std::unique_ptr<Chunk> chunk);
+    // nullptr if coord is not retained
+    std::unique_ptr<Chunk> Take(const ChunkCoord& coord);
+
+    size_t   Size() const { return entries_.size(); }
+    uint64_t Hits() const { return hits_; }
+    uint64_t Misses() const { return misses_; }
+
+   private:
+    struct Entry {
+        std::unique_ptr<Chunk>          chunk;
+        std::list<ChunkCoord>::iterator lru;
+    };
+
+    size_t                                                capacity_;
+    std::list<ChunkCoord>                                 lru_;  // newest first
+    std::unordered_map<ChunkCoord, Entry, ChunkCoordHash> entries_;
+    uint64_t                                              hits_{}, misses_{};
+};
+}  // namespace pop::voxel
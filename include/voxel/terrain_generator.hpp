@@ -1,7 +1,13 @@
 #pragma once
 #include "fast_noise_lite.h"
+#include "glm/vec3.hpp"
+#include "voxel/chunk.hpp"
+
+#include <span>
 
 namespace pop::voxel::terrain {
+struct ColumnCache;
+
 class TerrainGenerator {
    public:
     static TerrainGenerator& GetInstance() {
@@ -14,9 +20,15 @@ class TerrainGenerator {
     TerrainGenerator& operator=(const TerrainGenerator&) = delete;
     TerrainGenerator& operator=(TerrainGenerator&&)      = delete;
 
-    float GetHeight(float x, float y, float z);
+    // World space surface height of the (x, z) column. Samples the density
+    // noise on the y = kHeightBias plane, so it follows the same hills as
+    // GetDensity but can never produce overhangs.
+    float GetHeight(float x, float z) const;
+    // GetHeight for a row-major block of columns starting at (x0, z0)
+    void GetHeights(std::span<float> heights, float x0, float z0,
+                    int width) const;
 
-    float GetDensity(float x, float y, float z);
+    float GetDensity(float x, float y, float z) const;
 
    private:
     TerrainGenerator();
@@ -25,4 +37,66 @@ class TerrainGenerator {
     const float   kHeightBias = 64.0f;  // Surface targets roughly y=64
     const float   kHardness   = 15.0f;  // How "steep" the density drop-off is
 };
+
+// Fills the voxels of one chunk. Implementations must be safe to call from
+// several threads at once.
+class Generator {
+   public:
+    virtual ~Generator() = default;
+
+    // Fills ColumnCache::height for generators that read it. Runs once per
+    // chunk, before GenerateDensity.
+    virtual void FillColumns(ColumnCache&      columns,
+                             const glm::ivec3& chunkOffset) const;
+
+    // Raw density stage: writes kStone where solid and kAir everywhere else,
+    // records columns.surface and columns.lowestAir and marks them resolved.
+    // Resolved columns come from the same chunk and may be trusted.
+    // voxels is laid out as Chunk::Index(x, y, z), chunkOffset is the world
+    // position of the chunk's (0, 0, 0) voxel.
+    virtual void GenerateDensity(std::span<Voxel>  voxels,
+                                 const glm::ivec3& chunkOffset,
+                                 ColumnCache&      columns) const = 0;
+
+    // Low detail density stage: one sample per lod^3 block of voxels, taken
+    // at the block center. cells is laid out as Chunk::LodIndex.
+    virtual void GenerateLodDensity(std::span<Voxel>  cells,
+                                    const glm::ivec3& chunkOffset,
+                                    int               lod) const = 0;
+
+    // FillColumns, GenerateDensity then PaintSurface
+    void Populate(std::span<Voxel>  voxels,
+                  const glm::ivec3& chunkOffset) const;
+};
+
+// Surface stage: turns raw stone/air columns into grass, sand, dirt and water.
+void PaintSurface(std::span<Voxel> voxels, const ColumnCache& columns);
+// Surface stage for the cells of a low detail chunk
+void PaintSurfaceLod(std::span<Voxel> cells, int lod);
+
+// Full 3D density: one noise sample per voxel, supports overhangs and caves.
+class DensityGenerator : public Generator {
+   public:
+    // No 2D noise: height stays unset
+    void FillColumns(ColumnCache&      columns,
+                     const glm::ivec3& chunkOffset) const override;
+    void GenerateDensity(std::span<Voxel>  voxels,
+                         const glm::ivec3& chunkOffset,
+                         ColumnCache&      columns) const override;
+    void GenerateLodDensity(std::span<Voxel>  cells,
+                            const glm::ivec3& chunkOffset,
+                            int               lod) const override;
+};
+
+// 2D heightmap: no noise of its own, each column is written from
+// ColumnCache::height as two contiguous runs.
+class HeightMapGenerator : public Generator {
+   public:
+    void GenerateDensity(std::span<Voxel>  voxels,
+                         const glm::ivec3& chunkOffset,
+                         ColumnCache&      columns) const override;
+    void GenerateLodDensity(std::span<Voxel>  cells,
+                            const glm::ivec3& chunkOffset,
+                            int               lod) const override;
+};
 }  // namespace pop::voxel::terrain
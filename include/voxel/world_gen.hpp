@@ -0,0 +1,83 @@
+#pragma once
+
+#include "glm/vec3.hpp"
+#include "voxel/chunk.hpp"
+#include "voxel/chunk_coord.hpp"
+#include "voxel/column_cache.hpp"
+#include "voxel/terrain_generator.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace pop::voxel::terrain {
+using GenStage = Chunk::GenStage;
+
+inline constexpr ChunkCoord kOrthogonalNeighbors[] = {
+    {0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+
+struct StageInfo {
+    GenStage stage;
+    // Neighbors (relative to the chunk being generated) the stage writes
+    // into. No stage reads its neighbors, and writes into chunks that are not
+    // generated yet are buffered, so none of them have to exist. Stages with
+    // no neighbors can run for any number of chunks in parallel.
+    std::span<const ChunkCoord> writesInto;
+};
+inline constexpr StageInfo kStages[] = {
+    {GenStage::kDensity, {}},
+    {GenStage::kSurface, {}},
+    // Trees may hang over one chunk border, never over a corner
+    {GenStage::kDecorated, kOrthogonalNeighbors},
+};
+
+// A voxel a stage wants to set in a chunk other than the one it generates.
+struct PendingWrite {
+    ChunkCoord  source;
+    glm::ivec3  local;
+    Voxel::Type vtype;
+};
+
+// Runs density -> surface -> decoration for chunks. Cross-chunk decoration
+// writes are never applied directly: they are buffered per target chunk and
+// the owner of that chunk applies them with ApplyPendingWrites. Generate and
+// the pending-write functions are safe to call from several threads as long
+// as each chunk is only touched by one of them.
+class WorldGenPipeline {
+   public:
+    explicit WorldGenPipeline(std::unique_ptr<Generator> generator);
+
+    void SetGenerator(std::unique_ptr<Generator> generator);
+
+    // Runs every stage up to and including target the chunk has not run yet.
+    // Chunks with lod > 1 never get past the surface stage.
+    void Generate(Chunk& chunk, const ChunkCoord& coord,
+                  GenStage target = GenStage::kDecorated);
+
+    // Applies and forgets the writes buffered for coord. The chunk must have
+    // finished the surface stage. Returns the number of voxels written.
+    // Low detail chunks keep their writes buffered and return 0.
+    size_t ApplyPendingWrites(Chunk& chunk, const ChunkCoord& coord);
+
+    // source is being unloaded: forget what it buffered for its neighbors.
+    void DropWritesFrom(const ChunkCoord& source);
+    // target is being unloaded while source stays: buffer source's writes
+    // into target again so they come back when target is regenerated.
+    void ReplayDecoration(const Chunk& source, const ChunkCoord& sourceCoord,
+                          const ChunkCoord& target);
+
+   private:
+    void Decorate(Chunk& chunk, const ChunkCoord& coord);
+    void Buffer(const ChunkCoord& target, const PendingWrite& write);
+
+    std::unique_ptr<Generator> generator_;
+    ColumnCacheStore           columns_;
+
+    std::mutex pending_mutex_;
+    std::unordered_map<ChunkCoord, std::vector<PendingWrite>, ChunkCoordHash>
+        pending_;
+};
+}  // namespace pop::voxel::terrain
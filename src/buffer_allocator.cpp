@@ -0,0 +1,87 @@
+#include "graphics/buffer_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace pop::gfx {
+BufferAllocator::BufferAllocator(size_t capacity) : capacity_{capacity} {
+    if (capacity > 0) InsertFree(0, capacity);
+}
+
+std::optional<BufferAllocator::Range> BufferAllocator::Allocate(size_t size) {
+    if (size == 0) return std::nullopt;
+    // Smallest block that fits, lowest offset among equal sizes
+    auto fit = free_by_size_.lower_bound({size, 0});
+    if (fit == free_by_size_.end()) return std::nullopt;
+    auto [blockSize, offset] = *fit;
+    EraseFree(free_by_offset_.find(offset));
+    if (blockSize > size) InsertFree(offset + size, blockSize - size);
+
+    used_ += size;
+    peak_  = std::max(peak_, used_);
+    return Range{offset, size};
+}
+
+void BufferAllocator::Free(const Range& range) {
+    assert(range.offset + range.size <= capacity_);
+    assert(used_ >= range.size);
+    used_ -= range.size;
+
+    size_t offset = range.offset, size = range.size;
+    auto   next   = free_by_offset_.lower_bound(offset);
+    assert(next == free_by_offset_.end() || next->first >= offset + size);
+    if (next != free_by_offset_.end() && next->first == offset + size) {
+        size += next->second;
+        next  = std::next(next);
+        EraseFree(std::prev(next));
+    }
+    if (next != free_by_offset_.begin()) {
+        auto prev = std::prev(next);
+        assert(prev->first + prev->second <= offset);
+        if (prev->first + prev->second == offset) {
+            offset  = prev->first;
+            size   += prev->second;
+            EraseFree(prev);
+        }
+    }
+    InsertFree(offset, size);
+}
+
+void BufferAllocator::Grow(size_t newCapacity) {
+    if (newCapacity <= capacity_) return;
+    size_t added = newCapacity - capacity_;
+    size_t start = capacity_;
+    capacity_    = newCapacity;
+    // Merge with a free block touching the old end
+    if (!free_by_offset_.empty()) {
+        auto last = std::prev(free_by_offset_.end());
+        if (last->first + last->second == start) {
+            start  = last->first;
+            added += last->second;
+            EraseFree(last);
+        }
+    }
+    InsertFree(start, added);
+}
+
+BufferAllocator::Stats BufferAllocator::GetStats() const {
+    Stats stats{capacity_, used_, peak_, free_by_offset_.size(), 0, 0.0f};
+    if (!free_by_size_.empty())
+        stats.largestFree = free_by_size_.rbegin()->first;
+    if (size_t freeTotal = capacity_ - used_)
+        stats.fragmentation =
+            1.0f - static_cast<float>(stats.largestFree) / freeTotal;
+    return stats;
+}
+
+void BufferAllocator::InsertFree(size_t offset, size_t size) {
+    free_by_offset_.emplace(offset, size);
+    free_by_size_.emplace(size, offset);
+}
+
+void BufferAllocator::EraseFree(std::map<size_t, size_t>::iterator it) {
+    free_by_size_.erase({it->second, it->first});
+    free_by_offset_.erase(it);
+}
+}  // namespace pop::gfx
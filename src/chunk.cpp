@@ -5,7 +5,7 @@
 #include "graphics/rendertypes.hpp"
 #include "graphics/shader.hpp"
 #include "graphics/vertex_buffers.hpp"
-#include "voxel/terrain_generator.hpp"
+#include <cassert>
 #include <iostream>
 #include <memory>
 
@@ -13,22 +13,33 @@ namespace pop::voxel {
 
 // ===============Chunk Renderable==============
 ChunkRenderable::ChunkRenderable(gfx::ShaderHandle shaderId, bool isTransparent)
-    : is_transparent_(isTransparent),
-      shader_id_{shaderId},
-      vertex_data_{std::make_unique<std::vector<float>>()} {}
+    : is_transparent_(isTransparent), shader_id_{shaderId} {}
 
 ChunkRenderable::~ChunkRenderable() {
-    // std::cout << "Chunk renderable destructor called, vao_ " << vao_.id()
-    //           << "\n";
+    if (pool_ && range_) pool_->Free(*range_);
+}
+std::vector<gfx::Attribute> ChunkRenderable::VertexAttributes() {
+    constexpr GLsizei stride = kVertexStride;
+    return {{0, 3, gfx::GLType::kFloat, false, stride, 0},
+            {1, 2, gfx::GLType::kFloat, false, stride, 3 * sizeof(float)},
+            {2, 1, gfx::GLType::kFloat, false, stride, 5 * sizeof(float)},
+            {3, 1, gfx::GLType::kFloat, false, stride, 6 * sizeof(float)}};
 }
 gfx::ShaderHandle ChunkRenderable::GetShaderProgId() const {
     return shader_id_;
 }
-void ChunkRenderable::AddAttribute(const gfx::Attribute &attribute) {
-    attributes_.push_back(attribute);
+void ChunkRenderable::Publish(std::vector<float> &&vertices) {
+    std::optional<gfx::StreamBuffer::Staged> staged;
+    if (pool_)
+        staged = pool_->Stage(vertices.data(),
+                              vertices.size() / kFloatsPerVertex);
+    auto mesh = std::make_shared<const ChunkMesh>(
+        ChunkMesh{std::move(vertices), ++published_version_, staged});
+    if (pending_mesh_.exchange(std::move(mesh))) superseded_meshes_++;
 }
-void ChunkRenderable::AddVertexData(const std::vector<float> &data) {
-    vertex_data_->insert(vertex_data_->end(), data.begin(), data.end());
+size_t ChunkRenderable::GetUploadSize() const {
+    auto mesh = pending_mesh_.load();
+    return mesh ? mesh->vertices.size() * sizeof(float) : 0;
 }
 void ChunkRenderable::AddTexture(
     std::shared_ptr<gfx::rtypes::TextureBinding> texture) {
@@ -42,44 +53,68 @@ void ChunkRenderable::AddTexture(
     textures_.emplace_back(std::move(texture));
 }
 void ChunkRenderable::Upload() {
-    if (!vertex_data_ || vertex_data_->empty()) {
-        // std::cout << "Upload called on empty data\n";
+    // Taking the mesh out leaves the mesher free to publish the next one
+    auto mesh = pending_mesh_.exchange(nullptr);
+    if (!mesh) return;
+    if (mesh->version <= uploaded_version_) {
+        superseded_meshes_++;
         return;
     }
-    if (attributes_.empty()) {
-        std::cout << "Attributes not filled\n";
+    if (!pool_) {
+        std::cerr << "Chunk renderable uploaded without a vertex pool\n";
+        return;
     }
+    uploaded_version_ = mesh->version;
 
-    vao_.Bind();
-    vbo_.Bind();
-
-    vbo_.BufferData(vertex_data_->size() * sizeof(float), vertex_data_->data(),
-                    GL_DYNAMIC_DRAW);
-
-    if (first_upload_) {
-        for (const auto &attr : attributes_) {
-            vao_.AddAttribute(attr);
-        }
+    size_t vertices = mesh->vertices.size() / kFloatsPerVertex;
+    // Freed first so a mesh that barely changed can coalesce back into its
+    // old range
+    if (range_) pool_->Free(*range_);
+    range_.reset();
+    num_vertices_ = 0;
+    // An empty version still replaces the old one, e.g. the last water
+    // block of a chunk was removed
+    if (vertices == 0) return;
+    range_ = pool_->Allocate(vertices);
+    if (!range_) {
+        std::cerr << "Vertex pool could not fit " << vertices
+                  << " vertices\n";
+        return;
     }
-    vbo_.UnBind();
-    vao_.UnBind();
-    num_vertices_ = vertex_data_->size() / 7;
-    // std::cout << "Chunk Renderale uploaded " << vertex_data_->size()
-    //           << " values; vao_: " << vao_.id() << "\n";
-    vertex_data_->clear();  // free heap memmory after sending it to gpu
-    first_upload_ = false;
+    // Staged by the mesher: only the GPU copy is left to issue here
+    if (!mesh->staged || !pool_->WriteStaged(*range_, *mesh->staged))
+        pool_->Write(*range_, mesh->vertices.data());
+    num_vertices_ = static_cast<int>(vertices);
 }
-void ChunkRenderable::Draw(gfx::ShaderProgram *const shader_program) {
-    if (!vertex_data_) return;
-    vao_.Bind();
+void ChunkRenderable::Draw(gfx::ShaderProgram *const /*shader_program*/) {
+    if (!range_ || num_vertices_ == 0) return;
+    pool_->Bind();
 
     for (auto i : textures_) {
         i->texture->Bind(i->slot);
     }
-    shader_program->SetUniformFloat3("uChunkOffset", chunk_offset_.x,
-                                     chunk_offset_.y, chunk_offset_.z);
+    // Same per draw offset attribute as a batched draw, as a constant
+    glDisableVertexAttribArray(gfx::DrawBatch::kOffsetAttribute);
+    glVertexAttrib3f(gfx::DrawBatch::kOffsetAttribute, chunk_offset_.x,
+                     chunk_offset_.y, chunk_offset_.z);
+
+    glDrawArrays(GL_TRIANGLES, static_cast<GLint>(range_->offset),
+                 num_vertices_);
+}
 
-    glDrawArrays(GL_TRIANGLES, 0, num_vertices_);
+bool ChunkRenderable::AddToBatch(gfx::DrawBatch &batch) {
+    if (!range_ || num_vertices_ == 0) return true;  // nothing to draw
+    batch.Add(*pool_, textures_, static_cast<GLint>(range_->offset),
+              num_vertices_, glm::vec3{chunk_offset_});
+    return true;
+}
+GLuint ChunkRenderable::GetTextureId() const {
+    return textures_.empty() ? 0 : textures_.front()->texture->GetHandle();
+}
+std::optional<util::AABB> ChunkRenderable::GetWorldBounds() const {
+    glm::vec3 min{chunk_offset_};
+    return util::AABB{
+        min, min + glm::vec3{Chunk::kSize_x, Chunk::kSize_y, Chunk::kSize_z}};
 }
 
 // ==============VOXEL==============
@@ -102,6 +137,11 @@ constexpr int VoxelTypeToTexture(const Voxel::Type &voxelType) {
             return 0;
         case Voxel::Type::kSand:
             return 1;
+        // No dedicated tiles in the atlas yet
+        case Voxel::Type::kTreeBark:
+            return 4;
+        case Voxel::Type::kTreeLeaves:
+            return 3;
         default:
             return 0;
     }
@@ -111,25 +151,32 @@ constexpr const float *FaceGeometry::GetFace(pop::direction faceDirection) {
     return kFaceTable[static_cast<int>(faceDirection)];
 }
 // ==============CHUNK===============
-Chunk::Chunk(glm::ivec3 chunkOffset) : chunk_offset_(chunkOffset) {
-    voxel_data_ = std::make_unique<Voxel[]>(kSize_x * kSize_y * kSize_z);
-    PopulateFromHeightMap();
+Chunk::Chunk(glm::ivec3 chunkOffset, int lod)
+    : chunk_offset_(chunkOffset), lod_(lod) {
+    assert(lod > 0 && kSize_x % lod == 0 && kSize_y % lod == 0 &&
+           kSize_z % lod == 0 && "Chunk lod must divide the chunk size");
+    voxel_data_ = std::make_unique<Voxel[]>(kVolume / (lod * lod * lod));
 }
 
-Voxel::Type Chunk::GetVoxelAtCoord(const glm::ivec3 &coord) const {
-    return voxel_data_[Index(coord.x, coord.y, coord.z)].GetType();
+std::span<Voxel> Chunk::Voxels() {
+    return {voxel_data_.get(),
+            static_cast<size_t>(kVolume / (lod_ * lod_ * lod_))};
+}
+std::span<const Voxel> Chunk::Voxels() const {
+    return {voxel_data_.get(),
+            static_cast<size_t>(kVolume / (lod_ * lod_ * lod_))};
 }
 
-constexpr int Chunk::Index(int x, int y, int z) {
-    return x + kSize_x * (y + kSize_y * z);
+Voxel::Type Chunk::GetVoxelAtCoord(const glm::ivec3 &coord) const {
+    return voxel_data_[LocalIndex(coord.x, coord.y, coord.z)].GetType();
 }
 
 void Chunk::BreakBlock(const glm::ivec3 &coord) {
-    SetVoxelType(Index(coord.x, coord.y, coord.z), Voxel::Type::kAir);
+    SetVoxelType(LocalIndex(coord.x, coord.y, coord.z), Voxel::Type::kAir);
 }
 
 void Chunk::AddBlock(const glm::ivec3 &coord, Voxel::Type vtype) {
-    SetVoxelType(Index(coord.x, coord.y, coord.z), vtype);
+    SetVoxelType(LocalIndex(coord.x, coord.y, coord.z), vtype);
 }
 void Chunk::SetVoxelType(int index, Voxel::Type vtype) {
     voxel_data_[index].SetType(vtype);
@@ -146,94 +193,38 @@ std::shared_ptr<ChunkRenderable> Chunk::GetRenderable(
 }
 
 void Chunk::GenerateMesh() {
-    for (int i = 0; i < kNumMeshes; i++)
+    for (int i = 0; i < kNumMeshes; i++) {
         meshes_[i] = std::make_shared<ChunkRenderable>(
             shader_ids_[i], gfx::rtypes::IsTransparentMesh(
                                 static_cast<gfx::rtypes::MeshType>(i)));
-
-    GenerateRenderable();
-}
-void Chunk::ReGenerate() {
-    for (int i = 0; i < kNumMeshes; i++) {
-        meshes_[i]->clearData();
+        // Before the engine sees it, the offset never changes afterwards
+        meshes_[i]->SetChunkOffset(chunk_offset_);
+        meshes_[i]->SetVertexPool(vertex_pool_);
     }
+
     GenerateRenderable();
 }
-void Chunk::PopulateFromHeightMap() {
-    auto &instance = terrain::TerrainGenerator::GetInstance();
-    auto  SetBlock = [&](int x, int y, int z, Voxel::Type vtype) {
-        voxel_data_[Index(x, y, z)].SetType(vtype);
-    };
-    for (int x = 0; x < kSize_x; x++) {
-        for (int z = 0; z < kSize_z; z++) {
-            bool surfaceFound = false;
-            for (int y = kSize_y - 1; y >= 0; y--) {
-                float density = instance.GetDensity(chunk_offset_.x + x,
-                                                    chunk_offset_.y + y,
-                                                    chunk_offset_.z + z);
-                if (density > 0) {
-                    if (!surfaceFound) {
-                        if (y >= kWaterBaseline - 1) {
-                            SetBlock(
-                                x, y, z,
-                                Voxel::Type::kGrass);  // The very top layer
-                        } else {
-                            SetBlock(x, y, z,
-                                     Voxel::Type::kSand);  // Underwater floor
-                        }
-                        surfaceFound = true;
-                    } else if (y > (kWaterBaseline - 4) &&
-                               y < (kWaterBaseline)) {
-                        // Just a little dirt/sand under the surface before
-                        // stone starts
-                        SetBlock(x, y, z, Voxel::Type::kDirt);
-                    } else {
-                        SetBlock(x, y, z,
-                                 Voxel::Type::kStone);  // Deep underground
-                    }
-                } else {
-                    if (y <= kWaterBaseline) {
-                        SetBlock(x, y, z,
-                                 Voxel::Type::kWater);  // Fill empty gaps below
-                                                        // sea level
-                    } else {
-                        SetBlock(x, y, z, Voxel::Type::kAir);
-                    }
-                }
-            }
-        }
-    }
-}
-
+void Chunk::ReGenerate() { GenerateRenderable(); }
 void Chunk::GenerateRenderable() {
-    for (int x = 0; x < kSize_x; x++) {
-        for (int y = 0; y < kSize_y; y++) {
-            for (int z = 0; z < kSize_z; z++) {
-                auto index = Index(x, y, z);
+    // Built on the side: the renderables may still be uploading the
+    // previous versions
+    std::array<std::vector<float>, kNumMeshes> vertices;
+    auto &solid = vertices[MeshToIndex(gfx::rtypes::MeshType::kSolidMesh)];
+    auto &water = vertices[MeshToIndex(gfx::rtypes::MeshType::kWaterMesh)];
+    // Walk in memory order (see Index)
+    for (int z = 0; z < CellsZ(); z++) {
+        for (int x = 0; x < CellsX(); x++) {
+            for (int y = 0; y < CellsY(); y++) {
+                auto index = LodIndex(x, y, z, lod_);
                 auto vtype = voxel_data_[index].GetType();
                 if (vtype == Voxel::Type::kAir) continue;
-                if (vtype == Voxel::Type::kWater)
-                    GenerateVoxel(x, y, z, vtype,
-                                  meshes_[MeshToIndex(
-                                      gfx::rtypes::MeshType::kWaterMesh)]);
-                else
-                    GenerateVoxel(x, y, z, vtype,
-                                  meshes_[MeshToIndex(
-                                      gfx::rtypes::MeshType::kSolidMesh)]);
+                GenerateVoxel(x, y, z, vtype,
+                              vtype == Voxel::Type::kWater ? water : solid);
             }
         }
     }
-    int stride = sizeof(float) * 7;
-    for (auto &mesh : meshes_) {
-        if (!mesh) continue;
-        mesh->AddAttribute({0, 3, gfx::GLType::kFloat, false, stride, 0});
-        mesh->AddAttribute(
-            {1, 2, gfx::GLType::kFloat, false, stride, 3 * sizeof(float)});
-        mesh->AddAttribute(
-            {2, 1, gfx::GLType::kFloat, false, stride, 5 * sizeof(float)});
-        mesh->AddAttribute(
-            {3, 1, gfx::GLType::kFloat, false, stride, 6 * sizeof(float)});
-        mesh->SetChunkOffset(chunk_offset_);
+    for (int i = 0; i < kNumMeshes; i++) {
+        if (meshes_[i]) meshes_[i]->Publish(std::move(vertices[i]));
     }
 }
 bool Chunk::ShouldDrawFace(Voxel::Type current, Voxel::Type neighbor) const {
@@ -250,42 +241,42 @@ bool Chunk::ShouldDrawFace(Voxel::Type current, Voxel::Type neighbor) const {
     }
 }
 void Chunk::GenerateVoxel(int x, int y, int z, Voxel::Type vtype,
-                          const std::shared_ptr<ChunkRenderable> &mesh) {
+                          std::vector<float> &verts) const {
     constexpr int floats_per_vertex = 5;
     constexpr int floats_per_face   = floats_per_vertex * 6;
 
-    auto &verts     = mesh->VertexData();
-    auto  emit_face = [&](direction dir) {
+    auto emit_face = [&](direction dir) {
         const float *face = FaceGeometry::GetFace(dir);
 
         for (int i = 0; i < floats_per_face; i += 5) {
-            verts.push_back(face[i + 0] + x);  // px
-            verts.push_back(face[i + 1] + y);  // py
-            verts.push_back(face[i + 2] + z);  // pz
-            verts.push_back(face[i + 3]);      // u
-            verts.push_back(face[i + 4]);      // v
+            verts.push_back((face[i + 0] + x) * lod_);  // px
+            verts.push_back((face[i + 1] + y) * lod_);  // py
+            verts.push_back((face[i + 2] + z) * lod_);  // pz
+            verts.push_back(face[i + 3]);               // u
+            verts.push_back(face[i + 4]);               // v
             verts.push_back(kNormalTable[static_cast<int>(dir)]);
-            verts.push_back(
-                VoxelTypeToTexture(voxel_data_[Index(x, y, z)].GetType()));
+            verts.push_back(VoxelTypeToTexture(vtype));
         }
     };
-    if (ShouldDrawFace(vtype, GetVoxelType(x, y + 1, z)))
+    // Neighbor lookups take full detail coordinates
+    const int vx = x * lod_, vy = y * lod_, vz = z * lod_;
+    if (ShouldDrawFace(vtype, GetVoxelType(vx, vy + lod_, vz)))
         emit_face(direction::kTop);
-    if (ShouldDrawFace(vtype, GetVoxelType(x, y - 1, z)))
+    if (ShouldDrawFace(vtype, GetVoxelType(vx, vy - lod_, vz)))
         emit_face(direction::kBottom);
-    if (ShouldDrawFace(vtype, GetVoxelType(x, y, z - 1)))
+    if (ShouldDrawFace(vtype, GetVoxelType(vx, vy, vz - lod_)))
         emit_face(direction::kNorth);
-    if (ShouldDrawFace(vtype, GetVoxelType(x, y, z + 1)))
+    if (ShouldDrawFace(vtype, GetVoxelType(vx, vy, vz + lod_)))
         emit_face(direction::kSouth);
-    if (ShouldDrawFace(vtype, GetVoxelType(x - 1, y, z)))
+    if (ShouldDrawFace(vtype, GetVoxelType(vx - lod_, vy, vz)))
         emit_face(direction::kWest);
-    if (ShouldDrawFace(vtype, GetVoxelType(x + 1, y, z)))
+    if (ShouldDrawFace(vtype, GetVoxelType(vx + lod_, vy, vz)))
         emit_face(direction::kEast);
 }
 Voxel::Type Chunk::GetLocalVoxelType(int x, int y, int z) const {
     assert(x < kSize_x && y < kSize_y && z < kSize_z &&
            "GetLocalVoxelType out of bounds");
-    return voxel_data_[Index(x, y, z)].GetType();
+    return voxel_data_[LocalIndex(x, y, z)].GetType();
 }
 Voxel::Type Chunk::GetVoxelType(int x, int y, int z) const {
     // 1. Local Check
@@ -312,7 +303,25 @@ Voxel::Type Chunk::GetVoxelType(int x, int y, int z) const {
         nx       = 0;
     }
 
-    return neighbor ? neighbor->GetLocalVoxelType(nx, ny, nz)
-                    : Voxel::Type::kAir;
+    if (!neighbor) return Voxel::Type::kAir;
+    // A coarser neighbor: LocalIndex reads the cell covering the voxel
+    if (neighbor->lod_ >= lod_) return neighbor->GetLocalVoxelType(nx, ny, nz);
+
+    // A finer neighbor: the face of this cell covers lod_ x lod_ of its
+    // voxels and must show wherever any of them would. Air shows every
+    // face, water only solid ones. Where the two surfaces disagree each
+    // side draws its own excess, so the border has no holes.
+    const bool  spansX  = nz != z;  // north or south neighbor
+    Voxel::Type weakest = neighbor->GetLocalVoxelType(nx, ny, nz);
+    for (int a = 0; a < lod_; a += neighbor->lod_) {
+        for (int b = 0; b < lod_; b += neighbor->lod_) {
+            auto type =
+                spansX ? neighbor->GetLocalVoxelType(nx + a, ny + b, nz)
+                       : neighbor->GetLocalVoxelType(nx, ny + b, nz + a);
+            if (type == Voxel::Type::kAir) return type;
+            if (type == Voxel::Type::kWater) weakest = type;
+        }
+    }
+    return weakest;
 }
 };  // namespace pop::voxel
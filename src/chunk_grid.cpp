@@ -0,0 +1,24 @@
+#include "voxel/chunk_grid.hpp"
+
+#include <cassert>
+
+namespace pop::voxel {
+ChunkGrid::ChunkGrid(int radius)
+    : radius_{radius},
+      size_{2 * radius + 1},
+      slots_(static_cast<size_t>(size_) * size_) {}
+
+void ChunkGrid::Insert(const ChunkCoord& coord, std::unique_ptr<Chunk> chunk) {
+    auto& slot = slots_[SlotIndex(coord)];
+    assert((!slot.chunk || slot.coord == coord) &&
+           "ChunkGrid slot still holds a chunk out of range");
+    slot.coord = coord;
+    slot.chunk = std::move(chunk);
+}
+
+std::unique_ptr<Chunk> ChunkGrid::Erase(const ChunkCoord& coord) {
+    auto& slot = slots_[SlotIndex(coord)];
+    if (!slot.chunk || slot.coord != coord) return nullptr;
+    return std::move(slot.chunk);
+}
+}  // namespace pop::voxel
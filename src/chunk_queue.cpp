@@ -0,0 +1,50 @@
+#include "voxel/chunk_queue.hpp"
+#include "glm/geometric.hpp"
+#include "glm/vec2.hpp"
+#include "voxel/chunk.hpp"
+
+#include <algorithm>
+
+namespace pop::voxel {
+namespace {
+// std heap functions build a max-heap
+bool MoreUrgentLast(const std::pair<float, ChunkCoord>& a,
+                    const std::pair<float, ChunkCoord>& b) {
+    return a.first > b.first;
+}
+}  // namespace
+
+float ChunkPriority(const ChunkCoord& coord, const glm::vec3& cameraPos,
+                    const glm::vec3& forward) {
+    glm::vec2 center{(coord.x + 0.5f) * Chunk::kSize_x,
+                     (coord.z + 0.5f) * Chunk::kSize_z};
+    glm::vec2 toChunk  = center - glm::vec2{cameraPos.x, cameraPos.z};
+    float     distance = glm::length(toChunk);
+    glm::vec2 look{forward.x, forward.z};
+    // Looking straight up or down every direction is as good as any other
+    if (distance < Chunk::kSize_x || glm::length(look) < 1e-3f)
+        return distance;
+
+    float facing = glm::dot(toChunk / distance, glm::normalize(look));
+    // facing 1 -> no penalty, -1 (straight behind) -> the full penalty
+    return distance *
+           (1.0f + ChunkPriorityQueue::kBehindPenalty * (1.0f - facing) * 0.5f);
+}
+
+void ChunkPriorityQueue::Rebuild(
+    const std::unordered_set<ChunkCoord, ChunkCoordHash>& coords,
+    const glm::vec3& cameraPos, const glm::vec3& forward) {
+    heap_.clear();
+    heap_.reserve(coords.size());
+    for (const auto& coord : coords)
+        heap_.emplace_back(ChunkPriority(coord, cameraPos, forward), coord);
+    std::make_heap(heap_.begin(), heap_.end(), MoreUrgentLast);
+}
+
+ChunkCoord ChunkPriorityQueue::Pop() {
+    std::pop_heap(heap_.begin(), heap_.end(), MoreUrgentLast);
+    ChunkCoord coord = heap_.back().second;
+    heap_.pop_back();
+    return coord;
+}
+}  // namespace pop::voxel
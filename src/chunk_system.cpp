@@ -1,7 +1,10 @@
 #include "voxel/chunk_system.hpp"
+#include <algorithm>
+#include <deque>
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
 #include <memory>
-#include <thread>
 #include "glm/geometric.hpp"
 #include "graphics/camera.hpp"
 #include "core/engine.hpp"
@@ -13,7 +16,10 @@
 
 namespace pop::voxel {
 ChunkManager::ChunkManager(const gfx::FlyCam* playerCam)
-    : player_cam_{playerCam} {
+    : loaded_chunks_{kMaxUnloadDistance},
+      retained_{kRetainedChunks},
+      pipeline_{std::make_unique<terrain::DensityGenerator>()},
+      player_cam_{playerCam} {
     std::cout << "Manager constructed!!\n";
 }
 
@@ -25,13 +31,21 @@ void ChunkManager::SetTexture(
     std::shared_ptr<gfx::rtypes::TextureBinding> tex) {
     tex_ = std::move(tex);
 }
+void ChunkManager::SetGenerator(
+    std::unique_ptr<terrain::Generator> generator) {
+    pipeline_.SetGenerator(std::move(generator));
+}
+int ChunkManager::LodForDistance(int distance) {
+    for (const auto& band : kLodBands)
+        if (distance <= band.maxDistance) return band.lod;
+    return kLodBands[std::size(kLodBands) - 1].lod;
+}
 Chunk* ChunkManager::GetRawChunkPtr(const ChunkCoord& coord) {
-    auto it = loaded_chunks_.find(coord);
-    return (it != loaded_chunks_.end()) ? it->second.get() : nullptr;
+    return loaded_chunks_.Find(coord);
 }
 void ChunkManager::UploadChunkToEngine(const ChunkCoord& chunkCoord,
                                        core::Engine& engine, bool update) {
-    auto& chunk = loaded_chunks_[chunkCoord];
+    Chunk* chunk = GetRawChunkPtr(chunkCoord);
 
     for (int i = 0; i < static_cast<int>(gfx::rtypes::MeshType::kMeshCount);
          i++) {
@@ -51,9 +65,10 @@ void ChunkManager::UploadChunkToEngine(const ChunkCoord& chunkCoord,
 }
 
 std::unique_ptr<Chunk> ChunkManager::GenerateChunk(
-    const ChunkCoord& chunkCoord) {
+    const ChunkCoord& chunkCoord, int lod) {
     auto chunkOffset = ChunkToOffset(chunkCoord);
-    auto chunk       = std::make_unique<Chunk>(chunkOffset);
+    auto chunk       = std::make_unique<Chunk>(chunkOffset, lod);
+    pipeline_.Generate(*chunk, chunkCoord, Chunk::GenStage::kSurface);
     for (size_t i = 0;
          i < static_cast<size_t>(gfx::rtypes::MeshType::kMeshCount); i++) {
         auto shader = shader_handles_[i];
@@ -61,10 +76,31 @@ std::unique_ptr<Chunk> ChunkManager::GenerateChunk(
             chunk->SetShader(static_cast<gfx::rtypes::MeshType>(i), shader);
         }
     }
+    // The meshes stage their vertices in the pool as they are built
+    chunk->SetVertexPool(vertex_pool_);
     return chunk;
 }
+void ChunkManager::DecorateChunks(const std::vector<ChunkCoord>& coords) {
+    for (const auto& coord : coords) {
+        auto* chunk = GetRawChunkPtr(coord);
+        // Writes buffered by already decorated neighbors
+        pipeline_.ApplyPendingWrites(*chunk, coord);
+        pipeline_.Generate(*chunk, coord, Chunk::GenStage::kDecorated);
+    }
+    // Trees only reach orthogonal neighbors. Those not meshed yet pick the
+    // writes up in their first mesh, the others need one more.
+    for (const auto& coord : coords) {
+        for (const auto& off : terrain::kOrthogonalNeighbors) {
+            const ChunkCoord neighborCoord = coord + off;
+            auto*            neighbor      = GetRawChunkPtr(neighborCoord);
+            if (neighbor &&
+                pipeline_.ApplyPendingWrites(*neighbor, neighborCoord))
+                dirty_chunks_.insert(neighborCoord);
+        }
+    }
+}
 void ChunkManager::LinkChunkNeighbors(const ChunkCoord& coord) {
-    auto& chunk = loaded_chunks_[coord];
+    Chunk* chunk = GetRawChunkPtr(coord);
 
     // Order: 0:Top, 1:Bottom, 2:North, 3:South, 4:West, 5:East
     Chunk::NeighborArray neighbors;
@@ -80,29 +116,160 @@ void ChunkManager::LinkChunkNeighbors(const ChunkCoord& coord) {
         GetRawChunkPtr(coord + ChunkCoord{1, 0});
     chunk->SetNeighbors(neighbors);
 }
-void ChunkManager::LinkAndMesh(const ChunkCoord& coord, core::Engine& engine) {
+void ChunkManager::SubmitMesh(std::deque<MeshJob>& meshing,
+                              const ChunkCoord& coord, bool remesh,
+                              std::span<const core::JobHandle> dependencies) {
+    // Linking reads the chunk map, so it stays on this thread. The meshing
+    // jobs only read voxels (their own and their neighbors') and publish
+    // their own chunk's meshes, so they can all run at once.
     LinkChunkNeighbors(coord);
-    auto& chunk = loaded_chunks_[coord];
-    chunk->GenerateMesh();
-    UploadChunkToEngine(coord, engine);
+    Chunk*    chunk    = GetRawChunkPtr(coord);
+    const int distance = render_distance_;
+    auto&     job = meshing.emplace_back(MeshJob{coord, remesh, false, {}});
+    job.handle    = jobs_.Submit(
+        [this, chunk, distance, &job, token = MakeToken(coord)] {
+            if (IsCancelled(token, distance)) {
+                job.dropped = true;
+                return;
+            }
+            if (job.remesh)
+                chunk->ReGenerate();
+            else
+                chunk->GenerateMesh();
+        },
+        dependencies);
+}
+void ChunkManager::FinishMeshes(std::deque<MeshJob>& meshing,
+                                core::Engine&        engine) {
+    const int distance = render_distance_;
+    for (auto& job : meshing) {
+        jobs_.Wait(job.handle);
+        if (job.dropped) {
+            cancelled_meshes_++;
+        } else if (IsCancelled(MakeToken(job.coord), distance)) {
+            cancelled_uploads_++;
+            wasted_meshes_++;
+            job.dropped = true;
+        }
+        if (job.dropped) {
+            // A dropped remesh leaves the old mesh up until it is redone
+            (job.remesh ? dirty_chunks_ : new_chunks_).insert(job.coord);
+            continue;
+        }
+        auto* chunk = GetRawChunkPtr(job.coord);
+        chunk->SetMeshState(Chunk::MeshState::kMeshed);
+        UploadChunkToEngine(job.coord, engine, job.remesh);
+        chunk->SetMeshState(Chunk::MeshState::kUploaded);
+    }
+    meshing.clear();
+}
+void ChunkManager::MeshChunks(const std::vector<ChunkCoord>& coords,
+                              bool remesh, core::Engine& engine) {
+    std::deque<MeshJob> meshing;
+    for (const auto& coord : coords) SubmitMesh(meshing, coord, remesh);
+    FinishMeshes(meshing, engine);
+}
+bool ChunkManager::IsMeshable(const ChunkCoord& coord) {
+    if (ChunkDistance(coord, center_) > render_distance_) return false;
+    for (const auto& off : terrain::kOrthogonalNeighbors)
+        if (!IsChunkLoaded(coord + off)) return false;
+    return true;
+}
+void ChunkManager::QueueIfMeshable(const ChunkCoord& coord) {
+    auto* chunk = GetRawChunkPtr(coord);
+    if (!chunk || chunk->GetMeshState() != Chunk::MeshState::kGenerated ||
+        !IsMeshable(coord))
+        return;
+    chunk->SetMeshState(Chunk::MeshState::kNeighborsReady);
+    new_chunks_.insert(coord);
+}
+void ChunkManager::OnChunkArrived(const ChunkCoord& coord, bool replaced) {
+    QueueIfMeshable(coord);
+    for (const auto& off : terrain::kOrthogonalNeighbors) {
+        auto* neighbor = GetRawChunkPtr(coord + off);
+        if (!neighbor) continue;
+        if (neighbor->GetMeshState() < Chunk::MeshState::kMeshed) {
+            QueueIfMeshable(coord + off);
+        } else if (replaced) {
+            // The border it was meshed against changed resolution
+            dirty_chunks_.insert(coord + off);
+        } else {
+            // Meshed neighbors already saw this chunk (or an identical one
+            // that was unloaded): remeshing them would change nothing
+            avoided_remeshes_++;
+        }
+    }
 }
 
 bool ChunkManager::IsChunkLoaded(const ChunkCoord& chunkCoord) {
-    return loaded_chunks_.count(chunkCoord);
+    return loaded_chunks_.Contains(chunkCoord);
 }
 
 void ChunkManager::UnLoadChunk(const ChunkCoord& chunkCoord,
                                core::Engine&     engine) {
-    assert(loaded_chunks_.count(chunkCoord) &&
+    assert(IsChunkLoaded(chunkCoord) &&
            "Unload call on already unloaded chunk");
 
     for (int i = 0; i < static_cast<int>(gfx::rtypes::MeshType::kMeshCount);
          i++) {
-        auto renderable = loaded_chunks_[chunkCoord]->GetRenderable(
+        auto renderable = GetRawChunkPtr(chunkCoord)->GetRenderable(
             static_cast<gfx::rtypes::MeshType>(i));
         if (!renderable) continue;
         engine.RemoveRenderable(renderable);
     }
+    // Keep the trees neighbors planted in this chunk for when it comes back
+    pipeline_.DropWritesFrom(chunkCoord);
+    for (const auto& off : terrain::kOrthogonalNeighbors) {
+        auto* neighbor = GetRawChunkPtr(chunkCoord + off);
+        if (neighbor)
+            pipeline_.ReplayDecoration(*neighbor, chunkCoord + off, chunkCoord);
+    }
+}
+
+void ChunkManager::RetireChunk(const ChunkCoord& coord, core::Engine& engine) {
+    UnLoadChunk(coord, engine);
+    auto evicted = retained_.Put(coord, loaded_chunks_.Erase(coord));
+    if (evicted) ReleaseChunk(*evicted, engine);
+}
+void ChunkManager::RestoreChunk(const ChunkCoord&      coord,
+                                std::unique_ptr<Chunk> chunk,
+                                core::Engine&          engine) {
+    bool meshed = chunk->GetMeshState() == Chunk::MeshState::kUploaded;
+    if (!meshed) chunk->SetMeshState(Chunk::MeshState::kGenerated);
+    loaded_chunks_.Insert(coord, std::move(chunk));
+    if (meshed) {
+        // Upload() keeps the GPU buffers when there is no new vertex data,
+        // so adding them again is free
+        for (int i = 0;
+             i < static_cast<int>(gfx::rtypes::MeshType::kMeshCount); i++) {
+            auto renderable = GetRawChunkPtr(coord)->GetRenderable(
+                static_cast<gfx::rtypes::MeshType>(i));
+            if (renderable) engine.AddRenderable(renderable);
+        }
+    }
+    OnChunkArrived(coord, false);
+
+    // Same hand over as a freshly decorated chunk: what its neighbors
+    // buffered for it while it was away, and its trees for them
+    if (pipeline_.ApplyPendingWrites(*GetRawChunkPtr(coord), coord))
+        dirty_chunks_.insert(coord);
+    for (const auto& off : terrain::kOrthogonalNeighbors) {
+        pipeline_.ReplayDecoration(*GetRawChunkPtr(coord), coord,
+                                   coord + off);
+        auto* neighbor = GetRawChunkPtr(coord + off);
+        if (neighbor && pipeline_.ApplyPendingWrites(*neighbor, coord + off))
+            dirty_chunks_.insert(coord + off);
+    }
+}
+void ChunkManager::ReleaseChunk(const Chunk& chunk, core::Engine& engine) {
+    // Removing a renderable the engine no longer draws is a no-op, but the
+    // command keeps it alive until the render thread processed it
+    for (int i = 0; i < static_cast<int>(gfx::rtypes::MeshType::kMeshCount);
+         i++) {
+        auto renderable =
+            chunk.GetRenderable(static_cast<gfx::rtypes::MeshType>(i));
+        if (renderable) engine.RemoveRenderable(renderable);
+    }
 }
 
 void ChunkManager::MarkDirty(const ChunkCoord& coord, bool markAll,
@@ -124,120 +291,338 @@ void ChunkManager::MarkDirty(const ChunkCoord& coord, bool markAll,
             dirty_chunks_.insert(coord + neighbors[2]);
     }
 }
-void ChunkManager::ProcessDirtyChunks(core::Engine& engine) {
-    for (auto it = dirty_chunks_.begin(); it != dirty_chunks_.end();) {
-        auto dirtyCoord = *it;
-        if (loaded_chunks_.find(dirtyCoord) == loaded_chunks_.end() ||
-            new_chunks_.count(dirtyCoord)) {
-            // removed from loaded chunks, will be rebuild when loaded again
-            // Also if in new chunk, this chunk hasn't been meshed so ignore
-        } else {
-            LinkChunkNeighbors(dirtyCoord);
-            loaded_chunks_[dirtyCoord]->ReGenerate();
-            UploadChunkToEngine(dirtyCoord, engine, true);
+template <typename Accept>
+void ChunkManager::MeshByPriority(
+    std::unordered_set<ChunkCoord, ChunkCoordHash>& queued,
+    const TickBudget& tickBudget, bool remesh, core::Engine& engine,
+    Accept accept) {
+    if (queued.empty()) return;
+    queue_.Rebuild(queued, player_cam_->GetPosition(),
+                   player_cam_->GetForward());
+    BudgetScope budget(tickBudget);
+    // Batches of one chunk per thread until the budget runs out
+    const size_t batchSize = jobs_.WorkerCount() + 1;
+    while (!queue_.Empty() && !budget.Exhausted()) {
+        std::vector<ChunkCoord> batch;
+        while (!queue_.Empty() && batch.size() < batchSize &&
+               static_cast<int>(batch.size()) < budget.Remaining()) {
+            auto coord = queue_.Pop();
+            queued.erase(coord);
+            if (accept(coord)) batch.push_back(coord);
         }
-        it = dirty_chunks_.erase(it);
+        MeshChunks(batch, remesh, engine);
+        for (size_t i = 0; i < batch.size(); i++) budget.Count();
     }
 }
+void ChunkManager::ProcessDirtyChunks(core::Engine& engine) {
+    MeshByPriority(dirty_chunks_, dirty_budget_, true, engine,
+                   [this](const ChunkCoord& coord) {
+                       // Unloaded chunks are rebuilt when loaded again, and
+                       // chunks without a mesh yet get the change in their
+                       // first one
+                       auto* chunk = GetRawChunkPtr(coord);
+                       return chunk && chunk->GetMeshState() >=
+                                           Chunk::MeshState::kMeshed;
+                   });
+}
 void ChunkManager::ProcessNewChunks(core::Engine& engine) {
-    for (auto it = new_chunks_.begin(); it != new_chunks_.end();) {
-        if (loaded_chunks_.count(*it)) LinkAndMesh(*it, engine);
-        it = new_chunks_.erase(it);
-    }
+    MeshByPriority(
+        new_chunks_, mesh_budget_, false, engine,
+        [this](const ChunkCoord& coord) {
+            auto* chunk = GetRawChunkPtr(coord);
+            if (!chunk ||
+                chunk->GetMeshState() != Chunk::MeshState::kNeighborsReady)
+                return false;
+            // A neighbor may have been unloaded, or the camera moved away,
+            // since it was queued. It is queued again by OnChunkArrived.
+            if (!IsMeshable(coord)) {
+                chunk->SetMeshState(Chunk::MeshState::kGenerated);
+                return false;
+            }
+            return true;
+        });
 }
 void ChunkManager::ProcessCommands() {
-    // TODO: benchmark with limited number of commands processed
-    while (!chunkCmdQ.empty()) {
-        auto cmd = chunkCmdQ.try_pop();
-        if (!cmd) return;
-        if (cmd->voxelToSet == Voxel::Type::kAir)
-            BreakBlock(cmd->position, cmd->direction);
+    // Bounded so a burst of edits cannot starve streaming, the rest is
+    // applied on the next passes. Edits only mark chunks dirty, so a chunk
+    // hit by many of them is still remeshed once.
+    for (const auto& cmd : chunkCmdQ.try_pop_many(kMaxCommandsPerTick)) {
+        if (cmd.voxelToSet == Voxel::Type::kAir)
+            BreakBlock(cmd.position, cmd.direction);
     }
 }
-void ChunkManager::Run(core::Engine& engine) {
-    std::cout << "Starting ChunkSystem" << std::endl;
-    InitialLoad(engine);
-    ChunkCoord lastChunk = WorldToChunkCoord(player_cam_->GetPosition());
-    while (engine.IsRunning()) {
-        auto currentChunk = WorldToChunkCoord(player_cam_->GetPosition());
+void ChunkManager::LoadArea(const ChunkCoord& center) {
+    center_        = center;
+    const int load = LoadDistance();
+    for (int x = -load; x <= load; x++)
+        for (int z = -load; z <= load; z++)
+            pending_chunks_.insert(center + ChunkCoord{x, z});
+}
+void ChunkManager::MoveArea(const ChunkCoord& center, core::Engine& engine) {
+    const ChunkCoord oldCenter = center_;
+    center_                    = center;
 
-        ProcessCommands();
-        ProcessDirtyChunks(engine);
-        ProcessNewChunks(engine);
+    ForEachSquareDifference(oldCenter, center, UnloadDistance(),
+                            [&](const ChunkCoord& coord) {
+                                if (IsChunkLoaded(coord))
+                                    RetireChunk(coord, engine);
+                            });
+    ForEachSquareDifference(oldCenter, center, LoadDistance(),
+                            [&](const ChunkCoord& coord) {
+                                pending_chunks_.erase(coord);
+                            });
+    // Chunks between the two radii may still be loaded
+    ForEachSquareDifference(center, oldCenter, LoadDistance(),
+                            [&](const ChunkCoord& coord) {
+                                if (!IsChunkLoaded(coord))
+                                    pending_chunks_.insert(coord);
+                            });
+    // The ring entering the render distance was loaded without a mesh
+    ForEachSquareDifference(
+        center, oldCenter, render_distance_,
+        [&](const ChunkCoord& coord) { QueueIfMeshable(coord); });
 
-        if (currentChunk == lastChunk) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    // A chunk changes LOD exactly when it crosses the edge of a band, which
+    // is the same kind of strip around every inner band's square
+    auto checkLod = [&](const ChunkCoord& coord) {
+        if (ChunkDistance(coord, center) > LoadDistance()) return;
+        auto* chunk = GetRawChunkPtr(coord);
+        // Chunks changing LOD stay visible until their replacement is ready
+        if (chunk &&
+            chunk->GetLod() != LodForDistance(ChunkDistance(coord, center)))
+            pending_chunks_.insert(coord);
+    };
+    for (const auto& band : kLodBands) {
+        if (band.maxDistance >= LoadDistance()) break;
+        ForEachSquareDifference(center, oldCenter, band.maxDistance, checkLod);
+        ForEachSquareDifference(oldCenter, center, band.maxDistance, checkLod);
+    }
+}
+void ChunkManager::ResizeArea(int distance, core::Engine& engine) {
+    const int oldDistance = render_distance_;
+    const int oldLoad     = LoadDistance();
+    const int oldUnload   = UnloadDistance();
+    render_distance_      = distance;
+    if (distance > oldDistance) {
+        // Chunks kept by the unload margin may have missed a band change
+        // while they were outside the load distance
+        ForEachSquareDifference(
+            center_, LoadDistance(), center_, oldLoad,
+            [&](const ChunkCoord& coord) {
+                auto* chunk = GetRawChunkPtr(coord);
+                int   lod   = LodForDistance(ChunkDistance(coord, center_));
+                if (!chunk || chunk->GetLod() != lod)
+                    pending_chunks_.insert(coord);
+            });
+        ForEachSquareDifference(
+            center_, distance, center_, oldDistance,
+            [&](const ChunkCoord& coord) { QueueIfMeshable(coord); });
+        return;
+    }
+    ForEachSquareDifference(center_, oldUnload, center_, UnloadDistance(),
+                            [&](const ChunkCoord& coord) {
+                                if (IsChunkLoaded(coord))
+                                    RetireChunk(coord, engine);
+                            });
+    ForEachSquareDifference(center_, oldLoad, center_, LoadDistance(),
+                            [&](const ChunkCoord& coord) {
+                                pending_chunks_.erase(coord);
+                            });
+}
+void ChunkManager::SetRenderDistance(int distance) {
+    distance = std::clamp(distance, kMinRenderDistance, kMaxRenderDistance);
+    if (requested_distance_.exchange(distance) != distance) wake_.Notify();
+}
+void ChunkManager::GeneratePending(core::Engine& engine) {
+    if (pending_chunks_.empty()) return;
+    queue_.Rebuild(pending_chunks_, player_cam_->GetPosition(),
+                   player_cam_->GetForward());
+
+    struct Slot {
+        ChunkCoord             coord;
+        int                    lod;
+        WorkToken              token;
+        std::unique_ptr<Chunk> chunk;
+        core::JobHandle        job;
+    };
+    const int        load = LoadDistance();
+    std::deque<Slot> slots;  // stable addresses for the jobs
+    while (!queue_.Empty() &&
+           static_cast<int>(slots.size()) < generation_budget_.maxChunks) {
+        auto coord = queue_.Pop();
+        pending_chunks_.erase(coord);
+        const WorkToken token = MakeToken(coord);
+        if (IsCancelled(token, load)) {
+            cancelled_generations_++;
+            pending_chunks_.insert(coord);
             continue;
         }
-        lastChunk = currentChunk;
-        std::unordered_set<ChunkCoord, ChunkCoordHash>
-            chunksToUnload;  // ,dirtyChunks
-        for (const auto& i : loaded_chunks_) chunksToUnload.insert(i.first);
-
-        for (int x = -RenderDistance; x <= RenderDistance; x++) {
-            for (int z = -RenderDistance; z <= RenderDistance; z++) {
-                auto nextChunk = currentChunk + ChunkCoord{x, z};
-                if (chunksToUnload.count(nextChunk)) {
-                    chunksToUnload.erase(nextChunk);
-                } else {
-                    new_chunks_.insert(nextChunk);
-                    loaded_chunks_[nextChunk] = GenerateChunk(nextChunk);
-                    MarkDirty(nextChunk, true);
-                }
+        int   lod = LodForDistance(ChunkDistance(coord, center_));
+        auto* old = GetRawChunkPtr(coord);
+        if (old && old->GetLod() == lod) continue;
+        if (auto retained = retained_.Take(coord)) {
+            if (!old && retained->GetLod() == lod) {
+                RestoreChunk(coord, std::move(retained), engine);
+                continue;
             }
+            ReleaseChunk(*retained, engine);
         }
-        // unload out of render distance chunks first so that GetRawptr in the
-        // linkneighbor is valid.
-        for (const auto& i : chunksToUnload) {
-            UnLoadChunk(i, engine);
-            loaded_chunks_.erase(i);
+        slots.push_back({coord, lod, token, nullptr, {}});
+    }
+    if (slots.empty()) return;
+
+    // The chunk local stages of the whole pick run at once. The workers
+    // keep generating while this thread commits each chunk as it finishes.
+    // Once the time budget runs out, jobs that have not started yet skip
+    // their chunk and it goes back to pending_chunks_.
+    BudgetScope       budget(generation_budget_);
+    std::atomic<bool> outOfTime{false};
+    std::unordered_map<ChunkCoord, core::JobHandle, ChunkCoordHash> generation;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> uncommitted;
+    for (auto& slot : slots) {
+        slot.job = jobs_.Submit([this, &slot, &outOfTime, load] {
+            if (!outOfTime.load(std::memory_order_relaxed) &&
+                !IsCancelled(slot.token, load))
+                slot.chunk = GenerateChunk(slot.coord, slot.lod);
+        });
+        generation.emplace(slot.coord, slot.job);
+        uncommitted.insert(slot.coord);
+    }
+
+    // Committing a chunk decorates it and writes into its neighbors, so a
+    // chunk is only meshed once nothing within two chunks of it is left to
+    // commit: its mesh reads it and its neighbors
+    auto commitsNear = [&uncommitted](const ChunkCoord& coord) {
+        for (int dx = -2; dx <= 2; dx++)
+            for (int dz = -2; dz <= 2; dz++)
+                if (std::abs(dx) + std::abs(dz) <= 2 &&
+                    uncommitted.contains(coord + ChunkCoord{dx, dz}))
+                    return true;
+        return false;
+    };
+    std::deque<MeshJob>     meshing;
+    std::vector<ChunkCoord> ready;  // meshable, waiting for commitsNear
+    auto                    startReady = [&] {
+        std::erase_if(ready, [&](const ChunkCoord& coord) {
+            if (commitsNear(coord)) return false;
+            auto* chunk = GetRawChunkPtr(coord);
+            if (!chunk || !new_chunks_.contains(coord) ||
+                chunk->GetMeshState() != Chunk::MeshState::kNeighborsReady)
+                return true;
+            new_chunks_.erase(coord);
+            // Mesh C after C and its 4 neighbors are generated
+            std::vector<core::JobHandle> dependencies;
+            for (const auto& off : terrain::kOrthogonalNeighbors)
+                if (auto it = generation.find(coord + off);
+                    it != generation.end())
+                    dependencies.push_back(it->second);
+            if (auto it = generation.find(coord); it != generation.end())
+                dependencies.push_back(it->second);
+            SubmitMesh(meshing, coord, false, dependencies);
+            return true;
+        });
+    };
+
+    for (auto& slot : slots) {
+        if (budget.Exhausted()) outOfTime = true;
+        // Chunks already being generated still finish and are committed
+        jobs_.Wait(slot.job);
+        uncommitted.erase(slot.coord);
+        if (!slot.chunk || IsCancelled(slot.token, load)) {
+            if (slot.chunk)
+                wasted_generations_++;
+            else if (IsCancelled(slot.token, load))
+                cancelled_generations_++;
+            pending_chunks_.insert(slot.coord);
+        } else {
+            bool replaced = IsChunkLoaded(slot.coord);
+            if (replaced) UnLoadChunk(slot.coord, engine);
+            loaded_chunks_.Insert(slot.coord, std::move(slot.chunk));
+            DecorateChunks({slot.coord});
+            OnChunkArrived(slot.coord, replaced);
+            // OnChunkArrived queues the chunk and the neighbors it completed
+            ready.push_back(slot.coord);
+            for (const auto& off : terrain::kOrthogonalNeighbors)
+                ready.push_back(slot.coord + off);
+            budget.Count();
         }
-        // regenerate dirty chunk and upload again
-        // for (const auto& dirtyCoord : dirtyChunks) {
-        //     if (loaded_chunks_.find(dirtyCoord) == loaded_chunks_.end())
-        //         continue;
-        //
-        //     if (newChunks.find(dirtyCoord) == newChunks.end()) {
-        //         UnLoadChunk(dirtyCoord, engine);
-        //         LinkChunkNeighbors(dirtyCoord);
-        //         loaded_chunks_[dirtyCoord]->ReGenerate();
-        //         UploadChunkToEngine(dirtyCoord, engine);
-        //     } else {
-        //         LinkAndMesh(dirtyCoord, engine);
-        //     }
-        // }
+        startReady();
     }
-    std::cout << "ChunkManager stopped!\n";
+    FinishMeshes(meshing, engine);
 }
-void ChunkManager::InitialLoad(core::Engine& engine) {
-    auto currentChunk = WorldToChunkCoord(player_cam_->GetPosition());
-    std::unordered_set<ChunkCoord, ChunkCoordHash> activeCoords;
-    for (int x = -RenderDistance; x <= RenderDistance; x++) {
-        for (int z = -RenderDistance; z <= RenderDistance; z++) {
-            auto nextChunk = ChunkCoord{currentChunk.x + x, currentChunk.z + z};
-            activeCoords.insert(nextChunk);
+void ChunkManager::Run(core::Engine& engine) {
+    using Clock = std::chrono::steady_clock;
+    std::cout << "Starting ChunkSystem" << std::endl;
+    render_distance_     = requested_distance_;
+    ChunkCoord lastChunk = WorldToChunkCoord(player_cam_->GetPosition());
+    LoadArea(lastChunk);
+
+    constexpr std::chrono::seconds kUtilizationWindow{1};
+    auto                           windowStart = Clock::now();
+    Clock::duration                idle{};
+    while (engine.IsRunning() && !stop_) {
+        // Before reading the camera, so work picked this pass is never
+        // stamped with a newer area than center_
+        area_epoch_       = camera_epoch_.load(std::memory_order_acquire);
+        auto currentChunk = WorldToChunkCoord(player_cam_->GetPosition());
+        if (currentChunk != lastChunk) {
+            lastChunk = currentChunk;
+            MoveArea(currentChunk, engine);
         }
-    }
-    for (const auto& coord : activeCoords) {
-        if (loaded_chunks_.find(coord) == loaded_chunks_.end()) {
-            loaded_chunks_[coord] = GenerateChunk(coord);
+        if (int distance = requested_distance_; distance != render_distance_)
+            ResizeArea(distance, engine);
+
+        ProcessCommands();
+        GeneratePending(engine);
+        ProcessDirtyChunks(engine);
+        ProcessNewChunks(engine);
+
+        // Out of work: sleep until the camera changes chunk or a command
+        // arrives. Work left over by the budgets runs on the next pass.
+        if (pending_chunks_.empty() && new_chunks_.empty() &&
+            dirty_chunks_.empty() && chunkCmdQ.empty()) {
+            auto waitStart = Clock::now();
+            wake_.Wait();
+            idle += Clock::now() - waitStart;
         }
-    }
-    for (const auto& coord : activeCoords) {
-        LinkAndMesh(coord, engine);
-    }
-    for (auto it = loaded_chunks_.begin(); it != loaded_chunks_.end();) {
-        if (activeCoords.find(it->first) == activeCoords.end()) {
-            UnLoadChunk(it->first, engine);
-            it = loaded_chunks_.erase(it);
-        } else {
-            ++it;
+        auto now = Clock::now();
+        if (now - windowStart >= kUtilizationWindow) {
+            std::chrono::duration<float> total       = now - windowStart;
+            std::chrono::duration<float> idleSeconds = idle;
+            utilization_ = 1.0f - idleSeconds.count() / total.count();
+            windowStart  = now;
+            idle         = {};
         }
     }
+    std::cout << "ChunkManager stopped!\n";
 }
 
+bool ChunkManager::IsCancelled(const WorkToken& token, int distance) const {
+    // Still the area the work was picked for
+    if (token.epoch == camera_epoch_.load(std::memory_order_acquire))
+        return false;
+    return ChunkDistance(token.coord, camera_chunk_.load()) > distance;
+}
+ChunkManager::CancelStats ChunkManager::GetCancelStats() const {
+    return {cancelled_generations_, cancelled_meshes_, cancelled_uploads_,
+            wasted_generations_, wasted_meshes_};
+}
 void ChunkManager::AddChunkBlockCmd(const ChunkBlockCmd& cmd) {
     chunkCmdQ.push(cmd);
+    wake_.Notify();
+}
+void ChunkManager::OnCameraMoved(const glm::vec3& position) {
+    auto chunk = WorldToChunkCoord(position);
+    if (has_notified_ && chunk == notified_chunk_) return;
+    has_notified_   = true;
+    notified_chunk_ = chunk;
+    camera_chunk_.store(chunk);
+    camera_epoch_.fetch_add(1, std::memory_order_release);
+    wake_.Notify();
+}
+void ChunkManager::Stop() {
+    stop_ = true;
+    wake_.Notify();
 }
 void ChunkManager::BreakBlock(glm::vec3 position, glm::vec3 dir) {
     util::Ray       ray(position, glm::normalize(dir));
@@ -253,9 +638,9 @@ void ChunkManager::BreakBlock(glm::vec3 position, glm::vec3 dir) {
         auto chunkCoord = WorldToChunkCoord(blockPos);
         auto localCoord = WorldToChunkLocal(blockPos);
 
-        auto it = loaded_chunks_.find(chunkCoord);
-        if (it != loaded_chunks_.end()) {
-            auto&       chunk        = it->second;
+        Chunk* chunk = GetRawChunkPtr(chunkCoord);
+        // Low detail chunks are out of reach anyway
+        if (chunk && chunk->GetLod() == 1) {
             Voxel::Type voxelHitType = chunk->GetVoxelAtCoord(localCoord);
             if (Voxel::IsSolid(voxelHitType)) {
                 chunk->BreakBlock(localCoord);
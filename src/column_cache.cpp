@@ -0,0 +1,38 @@
+#include "voxel/column_cache.hpp"
+
+namespace pop::voxel::terrain {
+
+ColumnCacheStore::ColumnCacheStore(size_t capacity) : capacity_{capacity} {}
+
+std::shared_ptr<const ColumnCache> ColumnCacheStore::Find(
+    const ChunkCoord& coord) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        it = entries_.find(coord);
+    if (it == entries_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.columns;
+}
+
+void ColumnCacheStore::Insert(const ChunkCoord&                  coord,
+                              std::shared_ptr<const ColumnCache> columns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        it = entries_.find(coord);
+    if (it != entries_.end()) {
+        it->second.columns = std::move(columns);
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return;
+    }
+    lru_.push_front(coord);
+    entries_[coord] = {std::move(columns), lru_.begin()};
+    if (entries_.size() > capacity_) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+}
+
+void ColumnCacheStore::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+}
+}  // namespace pop::voxel::terrain
@@ -0,0 +1,67 @@
+#include "graphics/draw_batch.hpp"
+
+#include <cassert>
+
+namespace pop::gfx {
+void DrawBatch::Add(VertexPool& pool, const Textures& textures, GLint first,
+                    GLsizei count, const glm::vec3& offset) {
+    if (commands_.empty()) {
+        pool_     = &pool;
+        textures_ = &textures;
+    }
+    assert(pool_ == &pool && "A batch draws from a single vertex pool");
+    // baseInstance picks this draw's entry of offsets_
+    commands_.push_back({static_cast<GLuint>(count), 1,
+                         static_cast<GLuint>(first),
+                         static_cast<GLuint>(offsets_.size())});
+    offsets_.push_back(offset);
+}
+
+void DrawBatch::Submit() {
+    if (commands_.empty()) return;
+    pool_->Bind();
+    for (const auto& binding : *textures_)
+        binding->texture->Bind(binding->slot);
+
+    if (SupportsIndirect()) {
+        // Respecified every frame: the driver orphans the old storage
+        // instead of waiting for draws still reading it
+        offset_buffer_.Bind();
+        offset_buffer_.BufferData(
+            static_cast<GLsizeiptr>(offsets_.size() * sizeof(glm::vec3)),
+            offsets_.data(), GL_STREAM_DRAW);
+        glVertexAttribPointer(kOffsetAttribute, 3, GL_FLOAT, GL_FALSE, 0,
+                              nullptr);
+        glVertexAttribDivisor(kOffsetAttribute, 1);
+        glEnableVertexAttribArray(kOffsetAttribute);
+
+        command_buffer_.Bind();
+        command_buffer_.BufferData(
+            static_cast<GLsizeiptr>(commands_.size() *
+                                    sizeof(DrawArraysIndirectCommand)),
+            commands_.data(), GL_STREAM_DRAW);
+        glMultiDrawArraysIndirect(GL_TRIANGLES, nullptr,
+                                  static_cast<GLsizei>(commands_.size()), 0);
+        command_buffer_.UnBind();
+    } else {
+        // A disabled attribute array reads the current constant value
+        glDisableVertexAttribArray(kOffsetAttribute);
+        for (size_t i = 0; i < commands_.size(); i++) {
+            glVertexAttrib3f(kOffsetAttribute, offsets_[i].x, offsets_[i].y,
+                             offsets_[i].z);
+            glDrawArrays(GL_TRIANGLES,
+                         static_cast<GLint>(commands_[i].first),
+                         static_cast<GLsizei>(commands_[i].count));
+        }
+    }
+    commands_.clear();
+    offsets_.clear();
+    pool_     = nullptr;
+    textures_ = nullptr;
+}
+
+bool DrawBatch::SupportsIndirect() {
+    // Set by glad when the context was loaded
+    return GLAD_GL_VERSION_4_3;
+}
+}  // namespace pop::gfx
@@ -3,6 +3,9 @@
 #include "graphics/camera.hpp"
 #include "glm/fwd.hpp"
 #include "graphics/shader.hpp"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
@@ -14,6 +17,12 @@ Engine::Engine(glm::mat4 projectionMatrix, GLFWwindow *window)
       window_(window),
       solid_renderables_{},
       projection_matrix_{projectionMatrix} {
+    // x=0 y=-1 z=0: straight down. Ambient is the light in the shadows
+    // (soft blueish gray to simulate sky reflection), diffuse the direct
+    // sun color (slightly warm/yellowish).
+    frame_uniforms_.sunDirection = {0.0f, -1.0f, 0.0f, 0.0f};
+    frame_uniforms_.sunAmbient   = {0.3f, 0.3f, 0.35f, 0.0f};
+    frame_uniforms_.sunDiffuse   = {0.8f, 0.8f, 0.7f, 0.0f};
     SetupCallbacks();
     is_running_ = true;
 }
@@ -23,6 +32,8 @@ bool Engine::IsRunning() const { return is_running_; }
 float Engine::GetDeltaTime() const { return delta_time_; }
 
 void Engine::AddShaderProgram(std::unique_ptr<gfx::ShaderProgram> shaderProg) {
+    shaderProg->BindUniformBlock(gfx::FrameUniforms::kBlockName,
+                                 gfx::FrameUniforms::kBinding);
     shader_prog_map_[shaderProg->id()] = std::move(shaderProg);
 }
 void Engine::AddRenderable(std::shared_ptr<Renderable> renderable) {
@@ -37,6 +48,9 @@ void Engine::RemoveRenderable(std::shared_ptr<Renderable> renderable) {
 void Engine::SetMainCamera(std::shared_ptr<gfx::Camera> cam) {
     main_camera_ = std::move(cam);
 }
+void Engine::SetFrameCallback(std::function<void()> callback) {
+    frame_callback_ = std::move(callback);
+}
 void Engine::SetupCallbacks() {
     glfwSetWindowUserPointer(window_, this);
     glfwSetCursorPosCallback(window_, MouseCallback);
@@ -57,32 +71,76 @@ void Engine::SetupCallbacks() {
     });
 }
 void Engine::ProcessCommands() {
-    // TODO: compare performance by limiting number of commands processed per
-    // turn
+    // Removes apply at once, uploads wait in pending_uploads_ for
+    // UploadPending so a burst of new chunks is spread over several frames
     while (true) {
         auto cmd = cmd_queue_.try_pop();
         if (!cmd) break;
+        Renderable *key = cmd->renderable.get();
         switch (cmd->type) {
             case RenderCmdType::kAdd:
-                // std::cout << "Added renderable\n";
-                cmd->renderable->Upload();
-                if (cmd->renderable->IsTransparent())
-                    transparent_renderables_.insert(std::move(cmd->renderable));
-                else
-                    solid_renderables_.insert(std::move(cmd->renderable));
+                pending_uploads_[key] = {std::move(cmd->renderable), true};
                 break;
             case RenderCmdType::kUpdate:
-                cmd->renderable->Upload();
+                // An add still waiting stays one: it is not drawn yet
+                pending_uploads_.try_emplace(
+                    key, PendingUpload{std::move(cmd->renderable), false});
                 break;
             case RenderCmdType::kRemove:
-                // std::cout << "removed renderable\n";
-                if (cmd->renderable->IsTransparent())
+                pending_uploads_.erase(key);
+                if (cmd->renderable->IsTransparent()) {
                     transparent_renderables_.erase(std::move(cmd->renderable));
-                else
+                    transparent_order_dirty_ = true;
+                } else
                     solid_renderables_.erase(std::move(cmd->renderable));
                 break;
         }
     }
+    UploadPending();
+}
+
+void Engine::UploadPending() {
+    if (pending_uploads_.empty()) return;
+
+    // Squared distance from the camera to the bounds, renderables without
+    // bounds first
+    glm::vec3 cameraPos = main_camera_->GetPosition();
+    std::vector<std::pair<float, Renderable *>> order;
+    order.reserve(pending_uploads_.size());
+    for (const auto &[key, pending] : pending_uploads_) {
+        float distance = 0.0f;
+        if (auto bounds = pending.renderable->GetWorldBounds()) {
+            glm::vec3 toBox =
+                glm::clamp(cameraPos, bounds->min, bounds->max) - cameraPos;
+            distance = glm::dot(toBox, toBox);
+        }
+        order.emplace_back(distance, key);
+    }
+    std::sort(order.begin(), order.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    auto   start = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        if (upload_budget_enabled_ && i > 0) {
+            float millis = std::chrono::duration<float, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+            if (bytes >= upload_budget_.maxBytes ||
+                millis >= upload_budget_.maxMillis)
+                break;
+        }
+        auto node    = pending_uploads_.extract(order[i].second);
+        auto pending = std::move(node.mapped());
+        bytes += pending.renderable->GetUploadSize();
+        pending.renderable->Upload();
+        if (!pending.add) continue;
+        if (pending.renderable->IsTransparent()) {
+            transparent_renderables_.insert(std::move(pending.renderable));
+            transparent_order_dirty_ = true;
+        } else
+            solid_renderables_.insert(std::move(pending.renderable));
+    }
 }
 
 void Engine::Run() {
@@ -93,24 +151,18 @@ void Engine::Run() {
     for (auto &renderable : solid_renderables_) {
         renderable->Upload();
     }
-    for (auto &prog : shader_prog_map_) {
-        prog.second->use();
-        prog.second->SetUniformMat4("projection", projection_matrix_, false);
-        // Direction: x=-0.2 (slightly from left), y=-1.0 (mostly down), z=-0.3
-        // (slightly from front)
-        prog.second->SetUniformFloat3("SunLight.direction", 0.0f, -1.0f, 0.0f);
-        // Ambient: The base light in the shadows (soft blueish gray to simulate
-        // sky reflection)
-        prog.second->SetUniformFloat3("SunLight.ambient", 0.3f, 0.3f, 0.35f);
-        // Diffuse: The direct sun color (slightly warm/yellowish)
-        prog.second->SetUniformFloat3("SunLight.diffuse", 0.8f, 0.8f, 0.7f);
-    }
+    // Allocated once, the binding point stays attached for the whole run
+    frame_ubo_.Bind();
+    frame_ubo_.BufferData(sizeof(gfx::FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, gfx::FrameUniforms::kBinding,
+                     frame_ubo_.id());
     std::cout << "Run init successful\n";
     while (!glfwWindowShouldClose(window_)) {
         ProcessCommands();
 
         UpdateDeltaTime();
         ProcessInput();
+        if (frame_callback_) frame_callback_();
         // if (rand() % 99) std::cout << "fps " << 1.0 / delta_time_ << "\n";
         Render();
 
@@ -123,39 +175,133 @@ void Engine::Run() {
 void Engine::Render() {
     glClearColor(0.53f, 0.81f, 0.92f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    auto viewMatrix = main_camera_->GetViewMatrix();
+    auto          viewMatrix = main_camera_->GetViewMatrix();
+    util::Frustum frustum{projection_matrix_ * viewMatrix};
+    render_stats_ = {};
+    UploadFrameUniforms(viewMatrix);
 
     // PASS 1: SOLID RENDERABLES
     glDisable(GL_BLEND);
     glDepthMask(GL_TRUE);
-    for (auto &drawable : solid_renderables_) {
-        auto current_shader_id = drawable->GetShaderProgId();
-        if (current_shader_id && shader_prog_map_[current_shader_id]) {
-            shader_prog_map_[current_shader_id]->use();
-            shader_prog_map_[current_shader_id]->SetUniformMat4(
-                "view", viewMatrix, false);
-
-            drawable->Draw(shader_prog_map_[current_shader_id].get());
-        }
-    }
+    DrawRenderables(solid_renderables_, frustum);
     // PASS 2: TRANSPARENT RENDERABLES (WATER)
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glDepthMask(GL_FALSE);
+    DrawTransparent(frustum);
 
-    for (auto &drawable : transparent_renderables_) {
-        auto current_shader_id = drawable->GetShaderProgId();
-        if (current_shader_id && shader_prog_map_[current_shader_id]) {
-            shader_prog_map_[current_shader_id]->use();
-            shader_prog_map_[current_shader_id]->SetUniformMat4(
-                "view", viewMatrix, false);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+}
 
-            drawable->Draw(shader_prog_map_[current_shader_id].get());
+void Engine::UploadFrameUniforms(const glm::mat4 &viewMatrix) {
+    frame_uniforms_.view           = viewMatrix;
+    frame_uniforms_.projection     = projection_matrix_;
+    frame_uniforms_.cameraPosition = glm::vec4{main_camera_->GetPosition(), 1};
+    frame_ubo_.Bind();
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(gfx::FrameUniforms),
+                    &frame_uniforms_);
+}
+uint64_t Engine::MakeSortKey(gfx::ShaderHandle shader, GLuint texture,
+                             GLuint vertexArray) {
+    // GL names are small sequential integers, 16 bits are plenty for
+    // programs and textures
+    return (static_cast<uint64_t>(shader & 0xffff) << 48) |
+           (static_cast<uint64_t>(texture & 0xffff) << 32) | vertexArray;
+}
+void Engine::DrawRenderables(
+    const std::unordered_set<std::shared_ptr<Renderable>> &renderables,
+    const util::Frustum                                   &frustum) {
+    draw_list_.clear();
+    for (auto &drawable : renderables) AddDrawItem(drawable.get(), frustum);
+    std::sort(
+        draw_list_.begin(), draw_list_.end(),
+        [](const DrawItem &a, const DrawItem &b) { return a.key < b.key; });
+    SubmitDrawList();
+}
+void Engine::DrawTransparent(const util::Frustum &frustum) {
+    glm::vec3 cameraPos = main_camera_->GetPosition();
+    glm::vec3 moved     = cameraPos - sorted_from_;
+    if (transparent_order_dirty_ ||
+        glm::dot(moved, moved) >
+            transparent_resort_distance_ * transparent_resort_distance_) {
+        auto start = std::chrono::steady_clock::now();
+        SortTransparent(cameraPos);
+        render_stats_.transparentSortMillis =
+            std::chrono::duration<float, std::milli>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+    }
+    // Kept in distance order: blending needs the far ones drawn first.
+    // Neighbors sharing a key still go into one batch, whose draws run in
+    // the order they were added.
+    draw_list_.clear();
+    for (Renderable *drawable : transparent_order_)
+        AddDrawItem(drawable, frustum);
+    SubmitDrawList();
+}
+void Engine::SortTransparent(const glm::vec3 &cameraPos) {
+    // Renderables without bounds count as right at the camera, last
+    std::vector<std::pair<float, Renderable *>> order;
+    order.reserve(transparent_renderables_.size());
+    for (const auto &drawable : transparent_renderables_) {
+        float distance = 0.0f;
+        if (auto bounds = drawable->GetWorldBounds()) {
+            glm::vec3 toCenter =
+                (bounds->min + bounds->max) * 0.5f - cameraPos;
+            distance = glm::dot(toCenter, toCenter);
+        }
+        order.emplace_back(distance, drawable.get());
+    }
+    std::sort(order.begin(), order.end(),
+              [](const auto &a, const auto &b) { return a.first > b.first; });
+    transparent_order_.clear();
+    for (const auto &[distance, drawable] : order)
+        transparent_order_.push_back(drawable);
+    sorted_from_             = cameraPos;
+    transparent_order_dirty_ = false;
+}
+void Engine::AddDrawItem(Renderable *drawable, const util::Frustum &frustum) {
+    if (frustum_culling_) {
+        auto bounds = drawable->GetWorldBounds();
+        if (bounds && !frustum.Intersects(*bounds)) {
+            render_stats_.culled++;
+            return;
         }
     }
+    auto shaderId = drawable->GetShaderProgId();
+    auto program  = shader_prog_map_.find(shaderId);
+    if (!shaderId || program == shader_prog_map_.end() || !program->second)
+        return;
+    draw_list_.push_back({MakeSortKey(shaderId, drawable->GetTextureId(),
+                                      drawable->GetVertexArrayId()),
+                          drawable, program->second.get()});
+}
+void Engine::SubmitDrawList() {
+    render_stats_.drawn += draw_list_.size();
 
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
+    // Draws with the same key go into one batch, submitted when the key
+    // changes, while its program is still the current one
+    auto submit = [this] {
+        if (batch_.Empty()) return;
+        render_stats_.drawCalls +=
+            gfx::DrawBatch::SupportsIndirect() ? 1 : batch_.Size();
+        batch_.Submit();
+    };
+    uint64_t batchKey = 0;
+    for (const auto &item : draw_list_) {
+        if (item.key != batchKey) {
+            submit();
+            batchKey = item.key;
+        }
+        // Skipped by the state cache unless the shader changed
+        item.program->use();
+        if (item.renderable->AddToBatch(batch_)) continue;
+        submit();  // keeps the list order
+        item.renderable->Draw(item.program);
+        render_stats_.drawCalls++;
+    }
+    submit();
 }
 
 void Engine::FramebufferSizeCallback(GLFWwindow *, int width, int height) {
@@ -165,6 +311,7 @@ void Engine::UpdateDeltaTime() {
     float currentTime = glfwGetTime();
     delta_time_       = currentTime - last_frame_time_;
     last_frame_time_  = currentTime;
+    frame_times_.Add(delta_time_ * 1000.0f);
 }
 
 void Engine::MouseCallback(GLFWwindow *window, double xpos, double ypos) {
@@ -0,0 +1,60 @@
+#include "graphics/gl_state_cache.hpp"
+
+namespace pop::gfx {
+void GLStateCache::UseProgram(GLuint program) {
+    if (program == program_) {
+        stats_.programs.skipped++;
+        return;
+    }
+    glUseProgram(program);
+    program_ = program;
+    stats_.programs.issued++;
+}
+
+void GLStateCache::BindVertexArray(GLuint vertexArray) {
+    if (vertexArray == vertex_array_) {
+        stats_.vertexArrays.skipped++;
+        return;
+    }
+    glBindVertexArray(vertexArray);
+    vertex_array_ = vertexArray;
+    stats_.vertexArrays.issued++;
+}
+
+void GLStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture) {
+    const TextureBinding binding{target, texture};
+    if (unit < kMaxUnits && textures_[unit] == binding) {
+        stats_.textures.skipped++;
+        return;
+    }
+    if (unit != active_unit_) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        active_unit_ = unit;
+    }
+    glBindTexture(target, texture);
+    // A unit with two targets bound only remembers the last one, which at
+    // worst costs a redundant bind later
+    if (unit < kMaxUnits) textures_[unit] = binding;
+    stats_.textures.issued++;
+}
+
+void GLStateCache::OnProgramDeleted(GLuint program) {
+    if (program == program_) program_ = kUnknown;
+}
+
+void GLStateCache::OnVertexArrayDeleted(GLuint vertexArray) {
+    if (vertexArray == vertex_array_) vertex_array_ = kUnknown;
+}
+
+void GLStateCache::OnTextureDeleted(GLuint texture) {
+    for (auto& binding : textures_)
+        if (binding.second == texture) binding = {};
+}
+
+void GLStateCache::Invalidate() {
+    program_      = kUnknown;
+    vertex_array_ = kUnknown;
+    active_unit_  = kUnknown;
+    textures_.fill({});
+}
+}  // namespace pop::gfx
@@ -0,0 +1,165 @@
+#include "core/job_system.hpp"
+
+#include <algorithm>
+
+namespace pop::core {
+namespace detail {
+struct JobNode {
+    JobSystem::Job job;
+    // Unfinished dependencies, plus one while Submit is still linking them
+    std::atomic<int>  remaining{1};
+    std::atomic<bool> done{false};
+
+    std::mutex                            mutex;  // guards dependents
+    std::vector<std::shared_ptr<JobNode>> dependents;
+};
+}  // namespace detail
+
+namespace {
+// Queue owned by the current thread, if it is a worker of owner
+struct WorkerIdentity {
+    const JobSystem* owner = nullptr;
+    size_t           index = 0;
+};
+thread_local WorkerIdentity tls_worker;
+}  // namespace
+
+bool JobHandle::IsDone() const { return !node_ || node_->done; }
+
+JobSystem::JobSystem(size_t workers) {
+    if (workers == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        workers     = hw > 1 ? hw - 1 : 1;
+    }
+    for (size_t i = 0; i < workers; i++)
+        queues_.push_back(std::make_unique<WorkQueue>());
+    for (size_t i = 0; i < workers; i++)
+        workers_.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (auto& worker : workers_) worker.join();
+}
+
+JobHandle JobSystem::Submit(Job job, std::span<const JobHandle> dependencies) {
+    auto node = std::make_shared<detail::JobNode>();
+    node->job = std::move(job);
+    waiting_++;
+    for (const auto& dep : dependencies) {
+        if (!dep.node_) continue;
+        std::lock_guard<std::mutex> lock(dep.node_->mutex);
+        // done is set under this mutex, so the dependency cannot finish
+        // between the check and the push
+        if (dep.node_->done) continue;
+        node->remaining++;
+        dep.node_->dependents.push_back(node);
+    }
+    JobHandle handle{node};
+    if (--node->remaining == 0) Schedule(std::move(node));
+    return handle;
+}
+
+void JobSystem::Schedule(NodePtr node) {
+    waiting_--;
+    size_t index = tls_worker.owner == this
+                       ? tls_worker.index
+                       : next_queue_++ % queues_.size();
+    {
+        // Counted before it is visible so FindJob never sees it uncounted.
+        // Under sleep_mutex_ so a worker about to sleep cannot miss it.
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        queued_++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->jobs.push_back(std::move(node));
+    }
+    sleep_cv_.notify_one();
+}
+
+JobSystem::NodePtr JobSystem::FindJob(size_t index) {
+    if (index != kNoQueue) {
+        auto&                       own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            auto node = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queued_--;
+            return node;
+        }
+    }
+    // Start at a different victim per thread to spread contention
+    size_t start = index == kNoQueue ? next_queue_.load() : index + 1;
+    for (size_t i = 0; i < queues_.size(); i++) {
+        size_t victim = (start + i) % queues_.size();
+        if (victim == index) continue;
+        auto&                       other = *queues_[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (other.jobs.empty()) continue;
+        auto node = std::move(other.jobs.front());
+        other.jobs.pop_front();
+        queued_--;
+        steals_++;
+        return node;
+    }
+    return nullptr;
+}
+
+void JobSystem::Execute(const NodePtr& node) {
+    node->job();
+    node->job = nullptr;  // release captures early
+    executed_++;
+
+    std::vector<NodePtr> dependents;
+    {
+        std::lock_guard<std::mutex> lock(node->mutex);
+        node->done = true;
+        dependents.swap(node->dependents);
+    }
+    node->done.notify_all();
+    for (auto& dependent : dependents)
+        if (--dependent->remaining == 0) Schedule(std::move(dependent));
+}
+
+bool JobSystem::TryRunOne(size_t index) {
+    auto node = FindJob(index);
+    if (!node) return false;
+    Execute(node);
+    return true;
+}
+
+void JobSystem::WorkerLoop(size_t index) {
+    tls_worker = {this, index};
+    while (true) {
+        if (TryRunOne(index)) continue;
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_) return;
+    }
+}
+
+void JobSystem::Wait(const JobHandle& handle) {
+    if (!handle.node_) return;
+    size_t index = tls_worker.owner == this ? tls_worker.index : kNoQueue;
+    while (!handle.node_->done) {
+        if (TryRunOne(index)) continue;
+        // Nothing to help with: the job or one of its dependencies is
+        // running elsewhere
+        handle.node_->done.wait(false);
+    }
+}
+
+void JobSystem::WaitAll(std::span<const JobHandle> handles) {
+    for (const auto& handle : handles) Wait(handle);
+}
+
+JobSystem::Stats JobSystem::GetStats() const {
+    return {workers_.size(), queued_.load(), waiting_.load(),
+            executed_.load(), steals_.load()};
+}
+}  // namespace pop::core
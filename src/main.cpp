@@ -8,11 +8,14 @@
 #include "gl/gl_types.hpp"
 #include "glm/fwd.hpp"
 #include "gl/popglfw.hpp"
+#include "graphics/gl_state_cache.hpp"
 #include "graphics/rendertypes.hpp"
 #include "graphics/shader.hpp"
+#include "graphics/vertex_pool.hpp"
 #include "stb_image.h"
 #include "graphics/camera.hpp"
 #include "voxel/chunk_system.hpp"
+#include "voxel/render_distance_controller.hpp"
 
 #include <iostream>
 #include <memory>
@@ -110,11 +113,120 @@ int main() {
     manager.SetShader(gfx::rtypes::MeshType::kSolidMesh, VoxelShader->id());
     manager.SetShader(gfx::rtypes::MeshType::kWaterMesh, WaterShader->id());
     manager.SetTexture(textureAtlas);
+    // Room for a few hundred typical chunk meshes, grows on demand
+    constexpr size_t kInitialPoolVertices = 1 << 22;
+    auto vertexPool = std::make_shared<gfx::VertexPool>(
+        voxel::ChunkRenderable::VertexAttributes(),
+        voxel::ChunkRenderable::kVertexStride, kInitialPoolVertices);
+    manager.SetVertexPool(vertexPool);
     engine.AddShaderProgram(std::move(VoxelShader));
     engine.AddShaderProgram(std::move(WaterShader));
+    // Water chunks are re-sorted back to front every half chunk of movement
+    engine.SetTransparentResortDistance(voxel::Chunk::kSize_x / 2.0f);
+    // Render distance: +/- step it by hand, R toggles the adaptive controller
+    voxel::RenderDistanceController distanceController;
+    bool                            adaptiveDistance = false;
+    engine.SetFrameCallback([&] {
+        manager.OnCameraMoved(cam->GetPosition());
+        if (adaptiveDistance)
+            manager.SetRenderDistance(distanceController.Update(
+                engine.GetDeltaTime(), manager.GetUtilization(),
+                manager.GetRenderDistance()));
+    });
+    engine.GetInputManager().RegisterKeyboardAction(GLFW_KEY_EQUAL, [&] {
+        adaptiveDistance = false;
+        manager.SetRenderDistance(manager.GetRenderDistance() + 1);
+        std::cout << "Render distance " << manager.GetRenderDistance() << "\n";
+    });
+    engine.GetInputManager().RegisterKeyboardAction(GLFW_KEY_MINUS, [&] {
+        adaptiveDistance = false;
+        manager.SetRenderDistance(manager.GetRenderDistance() - 1);
+        std::cout << "Render distance " << manager.GetRenderDistance() << "\n";
+    });
+    engine.GetInputManager().RegisterKeyboardAction(GLFW_KEY_R, [&] {
+        adaptiveDistance = !adaptiveDistance;
+        std::cout << "Adaptive render distance "
+                  << (adaptiveDistance ? "on" : "off") << "\n";
+    });
+    engine.GetInputManager().RegisterKeyboardAction(GLFW_KEY_C, [&engine] {
+        auto stats = engine.GetRenderStats();
+        std::cout << "Drawn " << stats.drawn << ", culled " << stats.culled
+                  << " renderables last frame in " << stats.drawCalls
+                  << " draw calls, transparent sort "
+                  << stats.transparentSortMillis << " ms\n";
+        auto state = gfx::GLStateCache::GetInstance().GetStats();
+        std::cout << "Redundant binds skipped: " << state.programs.skipped
+                  << "/" << state.programs.issued + state.programs.skipped
+                  << " programs, " << state.vertexArrays.skipped << "/"
+                  << state.vertexArrays.issued + state.vertexArrays.skipped
+                  << " vertex arrays, " << state.textures.skipped << "/"
+                  << state.textures.issued + state.textures.skipped
+                  << " textures\n";
+        gfx::GLStateCache::GetInstance().ResetStats();
+    });
+    engine.GetInputManager().RegisterKeyboardAction(GLFW_KEY_F, [&engine] {
+        engine.SetFrustumCulling(!engine.IsFrustumCulling());
+        std::cout << "Frustum culling "
+                  << (engine.IsFrustumCulling() ? "on" : "off") << "\n";
+    });
+    engine.GetInputManager().RegisterKeyboardAction(GLFW_KEY_B, [vertexPool] {
+        auto stats = vertexPool->GetStats();
+        std::cout << "Vertex pool: " << stats.vertices.used << "/"
+                  << stats.vertices.capacity << " vertices used, peak "
+                  << stats.vertices.peak << ", " << stats.vertices.freeBlocks
+                  << " free blocks (largest " << stats.vertices.largestFree
+                  << "), fragmentation " << stats.vertices.fragmentation
+                  << ", " << stats.grows << " grows\n";
+        std::cout << "Uploads: " << stats.uploads.bytes / 1024 << " KiB in "
+                  << stats.uploads.copies << " copies through a "
+                  << (stats.uploads.persistent ? "persistent mapped"
+                                               : "orphaned")
+                  << " ring, " << stats.uploads.wraps << " wraps, "
+                  << stats.uploads.waits << " fence waits\n";
+        std::cout << "Staged by the mesher: " << stats.uploads.staged
+                  << " copies, " << stats.uploads.expired
+                  << " overwritten before their upload\n";
+    });
+    // U reports the frame times since the last toggle, then flips the
+    // upload budget so both modes can be compared over the same walk
+    engine.GetInputManager().RegisterKeyboardAction(GLFW_KEY_U, [&engine] {
+        auto times = engine.GetFrameTimes();
+        std::cout << "Upload budget "
+                  << (engine.IsUploadBudgetEnabled() ? "on" : "off") << ": "
+                  << times.frames << " frames, p50 " << times.p50
+                  << " ms, p95 " << times.p95 << " ms, p99 " << times.p99
+                  << " ms, max " << times.max << " ms, "
+                  << engine.GetPendingUploads() << " uploads pending\n";
+        engine.SetUploadBudgetEnabled(!engine.IsUploadBudgetEnabled());
+        engine.ResetFrameTimes();
+        std::cout << "Upload budget "
+                  << (engine.IsUploadBudgetEnabled() ? "on" : "off") << "\n";
+    });
+    engine.GetInputManager().RegisterMouseAction(
+        GLFW_MOUSE_BUTTON_LEFT, [&manager, &cam] {
+            manager.AddChunkBlockCmd({cam->GetPosition(), cam->GetForward(),
+                                      voxel::Voxel::Type::kAir});
+        });
+    engine.GetInputManager().RegisterKeyboardAction(GLFW_KEY_J, [&manager] {
+        auto stats = manager.GetJobStats();
+        std::cout << "Jobs: " << stats.workers << " workers, "
+                  << stats.queued << " queued, " << stats.waiting
+                  << " waiting, " << stats.executed << " executed, "
+                  << stats.steals << " steals, "
+                  << manager.GetAvoidedRemeshes() << " remeshes avoided, "
+                  << voxel::ChunkRenderable::GetSupersededMeshes()
+                  << " meshes superseded before upload\n";
+        auto cancel = manager.GetCancelStats();
+        std::cout << "Cancelled: " << cancel.cancelledGenerations
+                  << " generations, " << cancel.cancelledMeshes
+                  << " meshes, " << cancel.cancelledUploads
+                  << " uploads; wasted: " << cancel.wastedGenerations
+                  << " generations, " << cancel.wastedMeshes << " meshes\n";
+    });
     std::thread chunkSystemThread{&voxel::ChunkManager::Run, &manager,
                                   std::ref(engine)};
     engine.Run();
+    manager.Stop();
     chunkSystemThread.join();
 
     // cleanup resources and terminate
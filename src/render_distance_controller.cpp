@@ -0,0 +1,38 @@
+#include "voxel/render_distance_controller.hpp"
+
+#include <algorithm>
+
+namespace pop::voxel {
+
+int RenderDistanceController::Update(float frameSec, float utilization,
+                                     int currentDistance) {
+    constexpr float kSmoothing = 0.05f;  // ~20 frames
+    constexpr float kTooSlow   = 1.1f;   // shrink above 110% of the target
+    constexpr float kHeadroom  = 0.75f;  // grow below 75% of the target
+
+    float frameMs = frameSec * 1000.0f;
+    smoothed_ms_  = smoothed_ms_ == 0.0f
+                        ? frameMs
+                        : smoothed_ms_ + kSmoothing * (frameMs - smoothed_ms_);
+    since_change_ += frameSec;
+    // Loading a grown ring saturates the chunk thread for a moment, only a
+    // thread that stays busy means it cannot keep up
+    bool saturated = utilization > settings_.maxUtilization;
+    saturated_for_ = saturated ? saturated_for_ + frameSec : 0.0f;
+    if (since_change_ < settings_.cooldownSec) return currentDistance;
+
+    int distance = currentDistance;
+    if (smoothed_ms_ > settings_.targetFrameMs * kTooSlow ||
+        saturated_for_ > settings_.saturatedSec) {
+        distance--;
+        saturated_for_ = 0.0f;
+    } else if (smoothed_ms_ < settings_.targetFrameMs * kHeadroom &&
+               !saturated) {
+        distance++;
+    }
+    distance = std::clamp(distance, settings_.minDistance,
+                          settings_.maxDistance);
+    if (distance != currentDistance) since_change_ = 0.0f;
+    return distance;
+}
+}  // namespace pop::voxel
@@ -0,0 +1,39 @@
+#include "voxel/retained_chunks.hpp"
+
+namespace pop::voxel {
+
+RetainedChunkCache::RetainedChunkCache(size_t capacity) : capacity_{capacity} {}
+
+std::unique_ptr<Chunk> RetainedChunkCache::Put(const ChunkCoord&      coord,
+                                               std::unique_ptr<Chunk> chunk) {
+    std::unique_ptr<Chunk> evicted;
+    auto                   it = entries_.find(coord);
+    if (it != entries_.end()) {
+        evicted = std::move(it->second.chunk);
+        lru_.erase(it->second.lru);
+        entries_.erase(it);
+    }
+    lru_.push_front(coord);
+    entries_[coord] = {std::move(chunk), lru_.begin()};
+    if (!evicted && entries_.size() > capacity_) {
+        auto oldest = entries_.find(lru_.back());
+        evicted     = std::move(oldest->second.chunk);
+        entries_.erase(oldest);
+        lru_.pop_back();
+    }
+    return evicted;
+}
+
+std::unique_ptr<Chunk> RetainedChunkCache::Take(const ChunkCoord& coord) {
+    auto it = entries_.find(coord);
+    if (it == entries_.end()) {
+        misses_++;
+        return nullptr;
+    }
+    hits_++;
+    auto chunk = std::move(it->second.chunk);
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+    return chunk;
+}
+}  // namespace pop::voxel
@@ -1,4 +1,5 @@
 #include "graphics/shader.hpp"
+#include "graphics/gl_state_cache.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include <fstream>
 #include <iostream>
@@ -98,59 +99,133 @@ bool Shader::Compile() {
     return true;
 }
 
+bool ShaderProgram::BindUniformBlock(std::string_view name, GLuint binding) {
+    GLuint index =
+        glGetUniformBlockIndex(program_id_, std::string(name).c_str());
+    if (index == GL_INVALID_INDEX) return false;
+    glUniformBlockBinding(program_id_, index, binding);
+    return true;
+}
+
+ShaderProgram::UniformLocation ShaderProgram::GetUniformLocation(
+    std::string_view name) const {
+    auto it = uniform_locations_.find(name);
+    return it == uniform_locations_.end() ? kNoUniform : it->second;
+}
+
 void ShaderProgram::SetUniformBool(std::string_view name, bool value) {
-    glUniform1i(glGetUniformLocation(program_id_, name.data()),
-                static_cast<int>(value));
+    SetUniformBool(GetUniformLocation(name), value);
 }
 
 void ShaderProgram::SetUniformInt(std::string_view name, int value) {
-    glUniform1i(glGetUniformLocation(program_id_, name.data()), value);
+    SetUniformInt(GetUniformLocation(name), value);
 }
 
 void ShaderProgram::SetUniformFloat(std::string_view name, float value) {
-    glUniform1f(glGetUniformLocation(program_id_, name.data()), value);
+    SetUniformFloat(GetUniformLocation(name), value);
 }
 
 void ShaderProgram::SetUniformFloat2(std::string_view name, float x, float y) {
-    glUniform2f(glGetUniformLocation(program_id_, name.data()), x, y);
+    SetUniformFloat2(GetUniformLocation(name), x, y);
 }
 
 void ShaderProgram::SetUniformFloat3(std::string_view name, float x, float y,
                                      float z) {
-    glUniform3f(glGetUniformLocation(program_id_, name.data()), x, y, z);
+    SetUniformFloat3(GetUniformLocation(name), x, y, z);
 }
 
 void ShaderProgram::SetUniformFloat4(std::string_view name, float x, float y,
                                      float z, float w) {
-    glUniform4f(glGetUniformLocation(program_id_, name.data()), x, y, z, w);
+    SetUniformFloat4(GetUniformLocation(name), x, y, z, w);
 }
 
 void ShaderProgram::SetUniformMat4(std::string_view name, glm::mat4 ptr,
                                    bool transpose) {
-    glUniformMatrix4fv(glGetUniformLocation(program_id_, name.data()), 1,
-                       transpose ? GL_TRUE : GL_FALSE, glm::value_ptr(ptr));
+    SetUniformMat4(GetUniformLocation(name), ptr, transpose);
+}
+
+void ShaderProgram::SetUniformBool(UniformLocation location, bool value) {
+    glUniform1i(location, static_cast<int>(value));
+}
+
+void ShaderProgram::SetUniformInt(UniformLocation location, int value) {
+    glUniform1i(location, value);
+}
+
+void ShaderProgram::SetUniformFloat(UniformLocation location, float value) {
+    glUniform1f(location, value);
+}
+
+void ShaderProgram::SetUniformFloat2(UniformLocation location, float x,
+                                     float y) {
+    glUniform2f(location, x, y);
+}
+
+void ShaderProgram::SetUniformFloat3(UniformLocation location, float x,
+                                     float y, float z) {
+    glUniform3f(location, x, y, z);
+}
+
+void ShaderProgram::SetUniformFloat4(UniformLocation location, float x,
+                                     float y, float z, float w) {
+    glUniform4f(location, x, y, z, w);
+}
+
+void ShaderProgram::SetUniformMat4(UniformLocation  location,
+                                   const glm::mat4& mat, bool transpose) {
+    glUniformMatrix4fv(location, 1, transpose ? GL_TRUE : GL_FALSE,
+                       glm::value_ptr(mat));
+}
+
+void ShaderProgram::CacheUniformLocations() {
+    uniform_locations_.clear();
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program_id_, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program_id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::string name(static_cast<size_t>(maxLength), '\0');
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+        glGetActiveUniform(program_id_, static_cast<GLuint>(i), maxLength,
+                           &length, &size, &type, name.data());
+        std::string uniform = name.substr(0, length);
+        GLint location = glGetUniformLocation(program_id_, uniform.c_str());
+        // Uniform block members have no location of their own
+        if (location == kNoUniform) continue;
+        // Arrays are reported as "name[0]", GL also accepts plain "name"
+        if (uniform.ends_with("[0]"))
+            uniform_locations_.emplace(uniform.substr(0, uniform.size() - 3),
+                                       location);
+        uniform_locations_.emplace(std::move(uniform), location);
+    }
 }
 
 ShaderProgram::ShaderProgram() : program_id_{glCreateProgram()} {}
 
 ShaderProgram::~ShaderProgram() {
     if (program_id_) {
+        GLStateCache::GetInstance().OnProgramDeleted(program_id_);
         glDeleteProgram(program_id_);
     }
 }
 ShaderProgram::ShaderProgram(ShaderProgram&& other) noexcept
-    : program_id_(other.program_id_), error_msg_(std::move(other.error_msg_)) {
+    : program_id_(other.program_id_),
+      error_msg_(std::move(other.error_msg_)),
+      uniform_locations_(std::move(other.uniform_locations_)) {
     other.program_id_ = 0;
 }
 
 ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other) noexcept {
     if (this != &other) {
         if (program_id_ != 0) {
+            GLStateCache::GetInstance().OnProgramDeleted(program_id_);
             glDeleteProgram(program_id_);
         }
 
-        program_id_ = other.program_id_;
-        error_msg_  = std::move(other.error_msg_);
+        program_id_        = other.program_id_;
+        error_msg_         = std::move(other.error_msg_);
+        uniform_locations_ = std::move(other.uniform_locations_);
 
         other.program_id_ = 0;
     }
@@ -176,11 +251,12 @@ bool ShaderProgram::Link() {
         return false;
     }
     error_msg_.clear();
+    CacheUniformLocations();
     return true;
 }
 
 void ShaderProgram::use() {
-    if (program_id_) glUseProgram(program_id_);
+    if (program_id_) GLStateCache::GetInstance().UseProgram(program_id_);
 }
 }  // namespace gfx
 }  // namespace pop
@@ -0,0 +1,218 @@
+#include "graphics/stream_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace pop::gfx {
+namespace {
+constexpr GLbitfield kPersistentFlags =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+constexpr GLuint64 kWaitTimeoutNs = 1'000'000;  // 1 ms
+}  // namespace
+
+bool StreamBuffer::SupportsPersistentMapping() {
+    return GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+}
+
+StreamBuffer::StreamBuffer(size_t capacity)
+    : capacity_{capacity - capacity % kSegments},
+      segment_size_{capacity_ / kSegments} {
+    buffer_.Bind();
+    if (SupportsPersistentMapping()) {
+        glBufferStorage(GL_COPY_READ_BUFFER,
+                        static_cast<GLsizeiptr>(capacity_), nullptr,
+                        kPersistentFlags);
+        mapped_ = static_cast<std::byte*>(
+            glMapBufferRange(GL_COPY_READ_BUFFER, 0,
+                             static_cast<GLsizeiptr>(capacity_),
+                             kPersistentFlags));
+        if (!mapped_) {
+            std::cerr << "Could not map the stream buffer persistently, "
+                         "falling back to orphaning\n";
+            // Immutable storage cannot be respecified, start over
+            buffer_ = GLBuffer{BufferType::kCopyReadBuffer};
+            buffer_.Bind();
+        }
+    }
+    if (!mapped_)
+        glBufferData(GL_COPY_READ_BUFFER, static_cast<GLsizeiptr>(capacity_),
+                     nullptr, GL_STREAM_DRAW);
+    buffer_.UnBind();
+    stats_.persistent = mapped_ != nullptr;
+    RefreshWindow();
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (GLsync fence : fences_)
+        if (fence) glDeleteSync(fence);
+    if (mapped_) {
+        buffer_.Bind();
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        buffer_.UnBind();
+    }
+}
+
+void StreamBuffer::Copy(GLuint dst, GLintptr dstOffset, const void* data,
+                        size_t bytes) {
+    auto* src = static_cast<const std::byte*>(data);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer_.id());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, dst);
+    while (bytes > 0) {
+        size_t piece  = std::min(bytes, segment_size_);
+        int    from   = segment_;
+        size_t offset = Reserve(piece);
+        if (mapped_) {
+            std::memcpy(mapped_ + offset, src, piece);
+        } else {
+            // Nothing still queued reads this range: it is past every
+            // earlier write since the last orphaning
+            void* ptr = glMapBufferRange(
+                GL_COPY_READ_BUFFER, static_cast<GLintptr>(offset),
+                static_cast<GLsizeiptr>(piece),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                    GL_MAP_UNSYNCHRONIZED_BIT);
+            if (!ptr) {
+                std::cerr << "Could not map the stream buffer\n";
+                break;
+            }
+            std::memcpy(ptr, src, piece);
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+        }
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            static_cast<GLintptr>(offset), dstOffset,
+                            static_cast<GLsizeiptr>(piece));
+        // Segments head_ moved past are fenced after the copy reading them
+        if (mapped_)
+            for (int s = from; s != segment_; s = (s + 1) % kSegments)
+                FenceSegment(s);
+
+        src += piece;
+        dstOffset += static_cast<GLintptr>(piece);
+        bytes -= piece;
+        stats_.bytes += piece;
+        stats_.copies++;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    RefreshWindow();
+}
+
+std::optional<StreamBuffer::Staged> StreamBuffer::Stage(const void* data,
+                                                        size_t      bytes) {
+    auto window = window_.load();
+    if (!window || bytes == 0) return std::nullopt;
+    std::optional<Staged> staged;
+    // Counted before checking closed: the render thread closes a window,
+    // then waits for its writers before the ring reuses it
+    window->writers++;
+    if (!window->closed) {
+        size_t offset = window->used.fetch_add(bytes);
+        if (offset + bytes <= window->size) {
+            std::memcpy(window->data + offset, data, bytes);
+            staged = Staged{window->position + offset, bytes};
+        }
+    }
+    window->writers--;
+    return staged;
+}
+
+bool StreamBuffer::CopyStaged(GLuint dst, GLintptr dstOffset,
+                              const Staged& staged) {
+    if (Position() > staged.position + capacity_) {
+        stats_.expired++;
+        return false;
+    }
+    size_t offset = staged.position % capacity_;
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer_.id());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, dst);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                        static_cast<GLintptr>(offset), dstOffset,
+                        static_cast<GLsizeiptr>(staged.bytes));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    // The window may be far behind head_: fence what this copy read
+    int first = SegmentOf(offset), last = SegmentOf(offset + staged.bytes - 1);
+    for (int s = first; s <= last; s++) FenceSegment(s);
+
+    stats_.bytes += staged.bytes;
+    stats_.copies++;
+    stats_.staged++;
+    RefreshWindow();
+    return true;
+}
+
+size_t StreamBuffer::Reserve(size_t bytes) {
+    size_t offset = head_;
+    if (offset + bytes > capacity_) {
+        if (!mapped_)
+            glBufferData(GL_COPY_READ_BUFFER,
+                         static_cast<GLsizeiptr>(capacity_), nullptr,
+                         GL_STREAM_DRAW);
+        offset = 0;
+        lap_++;
+        stats_.wraps++;
+    }
+    head_ = offset + bytes;
+    // Windows the ring came around to: no more Stage calls may write there
+    while (!windows_.empty() &&
+           Position() > windows_.front()->position + capacity_) {
+        Window& window = *windows_.front();
+        window.closed  = true;
+        while (window.writers.load()) std::this_thread::yield();
+        if (window_.load() == windows_.front()) window_.store(nullptr);
+        windows_.pop_front();
+    }
+    int last = SegmentOf(head_ - 1);
+    // Every segment entered from segment_ up to last may still be read by
+    // copies issued a full ring ago
+    if (mapped_)
+        for (int s = segment_; s != last;) {
+            s = (s + 1) % kSegments;
+            WaitSegment(s);
+        }
+    segment_ = last;
+    return offset;
+}
+
+void StreamBuffer::WaitSegment(int segment) {
+    GLsync& fence = fences_[segment];
+    if (!fence) return;
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        stats_.waits++;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      kWaitTimeoutNs);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        if (status == GL_WAIT_FAILED)
+            std::cerr << "Waiting for a stream buffer fence failed\n";
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::RefreshWindow() {
+    if (!mapped_) return;
+    auto window = window_.load();
+    if (window && window->used.load() < window->size / 2) return;
+    if (window) window->closed = true;
+
+    int    from   = segment_;
+    size_t offset = Reserve(segment_size_);
+    window        = std::make_shared<Window>(mapped_ + offset,
+                                             lap_ * capacity_ + offset,
+                                             segment_size_);
+    windows_.push_back(window);
+    window_.store(std::move(window));
+    // Copies up to now read the segments head_ moved past
+    for (int s = from; s != segment_; s = (s + 1) % kSegments)
+        FenceSegment(s);
+}
+
+void StreamBuffer::FenceSegment(int segment) {
+    if (fences_[segment]) glDeleteSync(fences_[segment]);
+    fences_[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+}  // namespace pop::gfx
@@ -1,5 +1,9 @@
 #include "voxel/terrain_generator.hpp"
 #include "voxel/chunk.hpp"
+#include "voxel/column_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 namespace pop::voxel::terrain {
 
@@ -11,7 +15,7 @@ TerrainGenerator::TerrainGenerator() {
 
     noise_.SetFrequency(kFrequency);
 }
-float TerrainGenerator::GetDensity(float x, float y, float z) {
+float TerrainGenerator::GetDensity(float x, float y, float z) const {
     float n3d = noise_.GetNoise(x, y, z);
 
     float heightGradient = (y - kHeightBias) / kHardness;
@@ -20,8 +24,201 @@ float TerrainGenerator::GetDensity(float x, float y, float z) {
     // Result: Positive at the bottom (solid), Negative at the top (air)
     return n3d - heightGradient;
 }
-float TerrainGenerator::GetHeight(float x, float y, float z) {
-    return noise_.GetNoise(x, y, z);
+float TerrainGenerator::GetHeight(float x, float z) const {
+    // Solving GetDensity(x, y, z) = 0 with the noise frozen at y = kHeightBias
+    return kHeightBias + kHardness * noise_.GetNoise(x, kHeightBias, z);
+}
+void TerrainGenerator::GetHeights(std::span<float> heights, float x0, float z0,
+                                  int width) const {
+    // The noise itself is scalar: gather the samples first so the scaling
+    // below is a plain loop the compiler can vectorize
+    for (size_t i = 0; i < heights.size(); i++) {
+        heights[i] = noise_.GetNoise(x0 + static_cast<float>(i % width),
+                                     kHeightBias,
+                                     z0 + static_cast<float>(i / width));
+    }
+    for (float &h : heights) h = kHeightBias + kHardness * h;
+}
+
+// ==============Generator==============
+void Generator::FillColumns(ColumnCache      &columns,
+                            const glm::ivec3 &chunkOffset) const {
+    TerrainGenerator::GetInstance().GetHeights(
+        columns.height, chunkOffset.x, chunkOffset.z, Chunk::kSize_x);
+}
+
+void Generator::Populate(std::span<Voxel>  voxels,
+                         const glm::ivec3& chunkOffset) const {
+    ColumnCache columns;
+    FillColumns(columns, chunkOffset);
+    GenerateDensity(voxels, chunkOffset, columns);
+    PaintSurface(voxels, columns);
+}
+
+namespace {
+// Paints one column from cell start down. WorldY maps a cell index to the
+// world height the painting rules are evaluated at.
+template <typename WorldY>
+void PaintColumn(std::span<Voxel> column, int start, WorldY worldY) {
+    bool surfaceFound = false;
+    for (int i = start; i >= 0; i--) {
+        int y = worldY(i);
+        if (column[i].GetType() == Voxel::Type::kStone) {
+            if (!surfaceFound) {
+                if (y >= Chunk::kWaterBaseline - 1) {
+                    column[i] = Voxel::Type::kGrass;  // The very top layer
+                } else {
+                    column[i] = Voxel::Type::kSand;  // Underwater floor
+                }
+                surfaceFound = true;
+            } else if (y > (Chunk::kWaterBaseline - 4) &&
+                       y < (Chunk::kWaterBaseline)) {
+                // Just a little dirt/sand under the surface before stone
+                // starts
+                column[i] = Voxel::Type::kDirt;
+            }
+            // Everything else stays stone, deep underground
+        } else if (y <= Chunk::kWaterBaseline) {
+            // Fill empty gaps below sea level
+            column[i] = Voxel::Type::kWater;
+        }
+    }
+}
+}  // namespace
+
+void PaintSurface(std::span<Voxel> voxels, const ColumnCache &columns) {
+    for (int z = 0; z < Chunk::kSize_z; z++) {
+        for (int x = 0; x < Chunk::kSize_x; x++) {
+            auto column = voxels.subspan(Chunk::Index(x, 0, z), Chunk::kSize_y);
+            // Nothing above the surface and the water line needs painting
+            int start = std::max(columns.SurfaceAt(x, z),
+                                 static_cast<int>(Chunk::kWaterBaseline));
+            start     = std::min(start, Chunk::kSize_y - 1);
+            PaintColumn(column, start, [](int y) { return y; });
+        }
+    }
+}
+
+void PaintSurfaceLod(std::span<Voxel> cells, int lod) {
+    const int cellsX = Chunk::kSize_x / lod, cellsY = Chunk::kSize_y / lod,
+              cellsZ = Chunk::kSize_z / lod;
+    for (int z = 0; z < cellsZ; z++) {
+        for (int x = 0; x < cellsX; x++) {
+            auto column = cells.subspan(Chunk::LodIndex(x, 0, z, lod), cellsY);
+            PaintColumn(column, cellsY - 1,
+                        [lod](int y) { return y * lod + lod / 2; });
+        }
+    }
+}
+
+// ==============DensityGenerator==============
+void DensityGenerator::FillColumns(ColumnCache & /*columns*/,
+                                   const glm::ivec3 & /*chunkOffset*/) const {
+    // Nothing reads the 2D heights: GenerateDensity records the surface
+    // from the density samples
+}
+
+void DensityGenerator::GenerateDensity(std::span<Voxel>  voxels,
+                                       const glm::ivec3& chunkOffset,
+                                       ColumnCache      &columns) const {
+    auto &instance = TerrainGenerator::GetInstance();
+    for (int z = 0; z < Chunk::kSize_z; z++) {
+        for (int x = 0; x < Chunk::kSize_x; x++) {
+            const int i      = ColumnCache::Index(x, z);
+            auto      column = voxels.subspan(Chunk::Index(x, 0, z),
+                                              Chunk::kSize_y);
+            // Known columns: solid below lowestAir, air above surface
+            int from = columns.resolved ? columns.lowestAir[i] : 0;
+            int to   = columns.resolved ? columns.surface[i] + 1
+                                        : Chunk::kSize_y;
+            std::fill(column.begin(), column.begin() + from,
+                      Voxel::Type::kStone);
+            std::fill(column.begin() + to, column.end(), Voxel::Type::kAir);
+
+            int top = -1, lowestAir = Chunk::kSize_y;
+            for (int y = from; y < to; y++) {
+                float density = instance.GetDensity(chunkOffset.x + x,
+                                                    chunkOffset.y + y,
+                                                    chunkOffset.z + z);
+                bool solid = density > 0;
+                column[y]  = solid ? Voxel::Type::kStone : Voxel::Type::kAir;
+                if (solid) top = y;
+                else if (lowestAir == Chunk::kSize_y) lowestAir = y;
+            }
+            if (columns.resolved) continue;
+            columns.surface[i]   = static_cast<int16_t>(top);
+            columns.lowestAir[i] = static_cast<int16_t>(lowestAir);
+        }
+    }
+    columns.resolved = true;
+}
+
+void DensityGenerator::GenerateLodDensity(std::span<Voxel>  cells,
+                                          const glm::ivec3& chunkOffset,
+                                          int               lod) const {
+    auto     &instance = TerrainGenerator::GetInstance();
+    const int cellsX = Chunk::kSize_x / lod, cellsY = Chunk::kSize_y / lod,
+              cellsZ = Chunk::kSize_z / lod;
+    for (int z = 0; z < cellsZ; z++) {
+        for (int x = 0; x < cellsX; x++) {
+            for (int y = 0; y < cellsY; y++) {
+                float density = instance.GetDensity(
+                    chunkOffset.x + x * lod + lod / 2,
+                    chunkOffset.y + y * lod + lod / 2,
+                    chunkOffset.z + z * lod + lod / 2);
+                cells[Chunk::LodIndex(x, y, z, lod)] =
+                    density > 0 ? Voxel::Type::kStone : Voxel::Type::kAir;
+            }
+        }
+    }
+}
+
+// ==============HeightMapGenerator==============
+void HeightMapGenerator::GenerateDensity(std::span<Voxel>  voxels,
+                                         const glm::ivec3& chunkOffset,
+                                         ColumnCache      &columns) const {
+    for (int z = 0; z < Chunk::kSize_z; z++) {
+        for (int x = 0; x < Chunk::kSize_x; x++) {
+            float height = columns.height[ColumnCache::Index(x, z)];
+            // Same rule as the density path: solid wherever y < height
+            int solid = static_cast<int>(std::ceil(height)) - chunkOffset.y;
+            solid     = std::clamp(solid, 0, Chunk::kSize_y);
+
+            // A column is contiguous in memory, so both runs are one fill
+            auto column = voxels.subspan(Chunk::Index(x, 0, z), Chunk::kSize_y);
+            std::fill(column.begin(), column.begin() + solid,
+                      Voxel::Type::kStone);
+            std::fill(column.begin() + solid, column.end(), Voxel::Type::kAir);
+            columns.surface[ColumnCache::Index(x, z)] =
+                static_cast<int16_t>(solid - 1);
+            columns.lowestAir[ColumnCache::Index(x, z)] =
+                static_cast<int16_t>(solid);
+        }
+    }
+    columns.resolved = true;
+}
+
+void HeightMapGenerator::GenerateLodDensity(std::span<Voxel>  cells,
+                                            const glm::ivec3& chunkOffset,
+                                            int               lod) const {
+    auto     &instance = TerrainGenerator::GetInstance();
+    const int cellsX = Chunk::kSize_x / lod, cellsY = Chunk::kSize_y / lod,
+              cellsZ = Chunk::kSize_z / lod;
+    for (int z = 0; z < cellsZ; z++) {
+        for (int x = 0; x < cellsX; x++) {
+            float height = instance.GetHeight(chunkOffset.x + x * lod + lod / 2,
+                                              chunkOffset.z + z * lod + lod / 2);
+            // A cell is solid when its center is below the surface
+            int solid = static_cast<int>(std::ceil(
+                (height - chunkOffset.y - lod / 2) / static_cast<float>(lod)));
+            solid     = std::clamp(solid, 0, cellsY);
+
+            auto column = cells.subspan(Chunk::LodIndex(x, 0, z, lod), cellsY);
+            std::fill(column.begin(), column.begin() + solid,
+                      Voxel::Type::kStone);
+            std::fill(column.begin() + solid, column.end(), Voxel::Type::kAir);
+        }
+    }
 }
 
 };  // namespace pop::voxel::terrain
@@ -1,4 +1,5 @@
 #include "graphics/texture.hpp"
+#include "graphics/gl_state_cache.hpp"
 #include "glad/glad.h"
 #include "stb_image.h"
 #include <iostream>
@@ -21,7 +22,8 @@ TextureFormat GetFormatFromChannels(int ch) {
 Texture::Texture(TextureType type)
     : width_{0}, height_{0}, nchannels_{0}, data_{nullptr}, tex_type_{type} {
     glGenTextures(1, &tex_id_);
-    glBindTexture(static_cast<GLenum>(tex_type_), tex_id_);
+    GLStateCache::GetInstance().BindTexture(
+        0, static_cast<GLenum>(tex_type_), tex_id_);
 
     // Default wrapping
     glTexParameteri(static_cast<GLenum>(tex_type_), GL_TEXTURE_WRAP_S,
@@ -39,7 +41,10 @@ Texture::~Texture() {
         stbi_image_free(data_);
         data_ = nullptr;
     }
-    if (tex_id_) glDeleteTextures(1, &tex_id_);
+    if (tex_id_) {
+        GLStateCache::GetInstance().OnTextureDeleted(tex_id_);
+        glDeleteTextures(1, &tex_id_);
+    }
 }
 
 Texture::Texture(Texture&& other) noexcept
@@ -56,7 +61,10 @@ Texture::Texture(Texture&& other) noexcept
 
 Texture& Texture::operator=(Texture&& other) noexcept {
     if (this != &other) {
-        if (tex_id_) glDeleteTextures(1, &tex_id_);
+        if (tex_id_) {
+            GLStateCache::GetInstance().OnTextureDeleted(tex_id_);
+            glDeleteTextures(1, &tex_id_);
+        }
         if (data_) stbi_image_free(data_);
 
         tex_id_    = other.tex_id_;
@@ -73,11 +81,16 @@ Texture& Texture::operator=(Texture&& other) noexcept {
     return *this;
 }
 void Texture::Bind(GLuint slot) const {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(static_cast<GLenum>(tex_type_), tex_id_);
+    GLStateCache::GetInstance().BindTexture(
+        slot, static_cast<GLenum>(tex_type_), tex_id_);
 }
 
-void Texture::Unbind() { glBindTexture(static_cast<GLenum>(tex_type_), 0); }
+void Texture::Unbind() {
+    // On whichever unit is active, the cache cannot tell which texture that
+    // leaves bound
+    glBindTexture(static_cast<GLenum>(tex_type_), 0);
+    GLStateCache::GetInstance().Invalidate();
+}
 
 bool Texture::LoadFromFile(std::string_view path, bool flip_vertically) {
     stbi_set_flip_vertically_on_load(flip_vertically);
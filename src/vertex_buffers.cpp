@@ -1,4 +1,5 @@
 #include "graphics/vertex_buffers.hpp"
+#include "graphics/gl_state_cache.hpp"
 #include <iostream>
 #include "glad/glad.h"
 
@@ -62,6 +63,7 @@ void VertexArray::Generate() {
 
 VertexArray::~VertexArray() {
     if (array_id_ != 0) {
+        GLStateCache::GetInstance().OnVertexArrayDeleted(array_id_);
         glDeleteVertexArrays(1, &array_id_);
     }
 }
@@ -73,6 +75,7 @@ VertexArray::VertexArray(VertexArray&& other) noexcept
 VertexArray& VertexArray::operator=(VertexArray&& other) noexcept {
     if (this != &other) {
         if (array_id_ != 0) {
+            GLStateCache::GetInstance().OnVertexArrayDeleted(array_id_);
             glDeleteVertexArrays(1, &array_id_);
         }
         array_id_       = other.array_id_;
@@ -83,10 +86,10 @@ VertexArray& VertexArray::operator=(VertexArray&& other) noexcept {
 
 void VertexArray::Bind() {
     if (!array_id_) Generate();
-    glBindVertexArray(array_id_);
+    GLStateCache::GetInstance().BindVertexArray(array_id_);
 }
 
-void VertexArray::UnBind() { glBindVertexArray(0); }
+void VertexArray::UnBind() { GLStateCache::GetInstance().BindVertexArray(0); }
 
 void VertexArray::AddAttribute(Attribute attribute) {
     Bind();
@@ -0,0 +1,86 @@
+#include "graphics/vertex_pool.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace pop::gfx {
+VertexPool::VertexPool(std::vector<Attribute> attributes, GLsizei stride,
+                       size_t initialVertices)
+    : attributes_{std::move(attributes)},
+      stride_{stride},
+      allocator_{initialVertices} {
+    vbo_.BufferData(static_cast<GLsizeiptr>(initialVertices) * stride_,
+                    nullptr, GL_DYNAMIC_DRAW);
+    SetupVertexArray();
+}
+
+std::optional<VertexPool::Range> VertexPool::Allocate(size_t vertices) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        range = allocator_.Allocate(vertices);
+    if (range) return range;
+    Grow(allocator_.Capacity() + vertices);
+    return allocator_.Allocate(vertices);
+}
+
+void VertexPool::Write(const Range& range, const void* data) {
+    staging_.Copy(vbo_.id(), static_cast<GLintptr>(range.offset) * stride_,
+                  data, range.size * stride_);
+}
+
+std::optional<StreamBuffer::Staged> VertexPool::Stage(const void* data,
+                                                      size_t      vertices) {
+    return staging_.Stage(data, vertices * stride_);
+}
+
+bool VertexPool::WriteStaged(const Range&                range,
+                             const StreamBuffer::Staged& staged) {
+    if (staged.bytes != range.size * stride_) return false;
+    return staging_.CopyStaged(
+        vbo_.id(), static_cast<GLintptr>(range.offset) * stride_, staged);
+}
+
+void VertexPool::Free(const Range& range) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    allocator_.Free(range);
+}
+
+void VertexPool::Bind() { vao_.Bind(); }
+
+VertexPool::Stats VertexPool::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {allocator_.GetStats(), grows_, staging_.GetStats()};
+}
+
+void VertexPool::Grow(size_t minVertices) {
+    const size_t oldCapacity = allocator_.Capacity();
+    // Doubling keeps the number of copies logarithmic in the final size
+    const size_t newCapacity = std::max(minVertices, oldCapacity * 2);
+
+    GLBuffer grown{BufferType::kArrayBuffer};
+    grown.BufferData(static_cast<GLsizeiptr>(newCapacity) * stride_, nullptr,
+                     GL_DYNAMIC_DRAW);
+    // Stays on the GPU, ranges keep their offsets
+    glBindBuffer(GL_COPY_READ_BUFFER, vbo_.id());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown.id());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        static_cast<GLsizeiptr>(oldCapacity) * stride_);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    vbo_ = std::move(grown);
+    SetupVertexArray();
+    allocator_.Grow(newCapacity);
+    grows_++;
+    std::cout << "Vertex pool grown to " << newCapacity << " vertices\n";
+}
+
+void VertexPool::SetupVertexArray() {
+    // The attribute pointers capture the buffer bound at the time
+    vao_.Bind();
+    vbo_.Bind();
+    for (const auto& attribute : attributes_) vao_.AddAttribute(attribute);
+    vao_.UnBind();
+    vbo_.UnBind();
+}
+}  // namespace pop::gfx
@@ -0,0 +1,213 @@
+#include "voxel/world_gen.hpp"
+#include "util/math.hpp"
+#include "voxel/chunk.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace pop::voxel::terrain {
+namespace {
+constexpr uint32_t kTreeChance     = 96;  // one tree per ~96 grass columns
+constexpr int      kCanopyRadius   = 2;
+constexpr int      kMinTrunkHeight = 4;
+
+uint32_t HashColumn(int x, int z) {
+    uint32_t h = static_cast<uint32_t>(x) * 0x8da6b343u ^
+                 static_cast<uint32_t>(z) * 0xd8163841u;
+    h ^= h >> 13;
+    h *= 0x85ebca6bu;
+    h ^= h >> 16;
+    return h;
+}
+
+bool CanOverwrite(Voxel::Type existing, Voxel::Type incoming) {
+    if (existing == Voxel::Type::kAir) return true;
+    // Trunks cut through leaves, leaves never replace anything solid
+    return incoming == Voxel::Type::kTreeBark &&
+           existing == Voxel::Type::kTreeLeaves;
+}
+
+// Calls sink(local, vtype) for every voxel of every tree rooted in chunk.
+// local is relative to chunk and may lie in one of its orthogonal neighbors.
+// Only reads the chunk, so it can be replayed at any time.
+template <typename Sink>
+void PlaceTrees(const Chunk& chunk, Sink&& sink) {
+    const auto& offset  = chunk.GetOffset();
+    const auto& columns = *chunk.GetColumns();
+    auto        voxels  = chunk.Voxels();
+    for (int z = 0; z < Chunk::kSize_z; z++) {
+        for (int x = 0; x < Chunk::kSize_x; x++) {
+            // Keep the canopy inside the chunk along at least one axis so a
+            // tree never reaches a diagonal neighbor
+            bool insideX = x >= kCanopyRadius &&
+                           x < Chunk::kSize_x - kCanopyRadius;
+            bool insideZ = z >= kCanopyRadius &&
+                           z < Chunk::kSize_z - kCanopyRadius;
+            if (!insideX && !insideZ) continue;
+
+            uint32_t hash = HashColumn(offset.x + x, offset.z + z);
+            if (hash % kTreeChance != 0) continue;
+
+            // Trees grow on grass, which only ever tops a column
+            int ground = columns.SurfaceAt(x, z);
+            if (ground < 0 || voxels[Chunk::Index(x, ground, z)].GetType() !=
+                                  Voxel::Type::kGrass)
+                continue;
+            int trunkTop = ground + kMinTrunkHeight +
+                           static_cast<int>((hash >> 8) % 3);
+            if (trunkTop + 2 > Chunk::kSize_y) continue;
+
+            for (int y = ground + 1; y <= trunkTop; y++)
+                sink(glm::ivec3{x, y, z}, Voxel::Type::kTreeBark);
+
+            for (int dy = -2; dy <= 1; dy++) {
+                int radius = dy < 0 ? kCanopyRadius : 1;
+                for (int dx = -radius; dx <= radius; dx++) {
+                    for (int dz = -radius; dz <= radius; dz++) {
+                        if (std::abs(dx) == radius && std::abs(dz) == radius)
+                            continue;  // round off the corners
+                        sink(glm::ivec3{x + dx, trunkTop + dy, z + dz},
+                             Voxel::Type::kTreeLeaves);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// The neighbor a chunk-relative position falls into, {0, 0} for the chunk
+ChunkCoord NeighborOf(const glm::ivec3& local) {
+    return {local.x < 0 ? -1 : (local.x >= Chunk::kSize_x ? 1 : 0),
+            local.z < 0 ? -1 : (local.z >= Chunk::kSize_z ? 1 : 0)};
+}
+}  // namespace
+
+WorldGenPipeline::WorldGenPipeline(std::unique_ptr<Generator> generator)
+    : generator_{std::move(generator)} {}
+
+void WorldGenPipeline::SetGenerator(std::unique_ptr<Generator> generator) {
+    generator_ = std::move(generator);
+    columns_.Clear();
+}
+
+void WorldGenPipeline::Generate(Chunk& chunk, const ChunkCoord& coord,
+                                GenStage target) {
+    if (chunk.GetLod() > 1) {
+        // Low detail chunks are too far away for trees to matter and have no
+        // per-voxel columns: they stop after the surface stage
+        if (chunk.GetStage() < GenStage::kDensity) {
+            generator_->GenerateLodDensity(chunk.Voxels(), chunk.GetOffset(),
+                                           chunk.GetLod());
+            chunk.SetStage(GenStage::kDensity);
+        }
+        if (chunk.GetStage() < GenStage::kSurface &&
+            target >= GenStage::kSurface) {
+            PaintSurfaceLod(chunk.Voxels(), chunk.GetLod());
+            chunk.SetStage(GenStage::kSurface);
+        }
+        return;
+    }
+    if (chunk.GetStage() < GenStage::kDensity && target >= GenStage::kDensity) {
+        // Regenerating a chunk reuses its columns: the 2D noise and the
+        // bounds the density stage found, so only the voxels between them
+        // are sampled again. The copy keeps the shared entry read-only.
+        auto cached  = columns_.Find(coord);
+        auto columns = cached ? std::make_shared<ColumnCache>(*cached)
+                              : std::make_shared<ColumnCache>();
+        if (!cached) generator_->FillColumns(*columns, chunk.GetOffset());
+        generator_->GenerateDensity(chunk.Voxels(), chunk.GetOffset(),
+                                    *columns);
+        if (!cached) columns_.Insert(coord, columns);
+        chunk.SetColumns(std::move(columns));
+        chunk.SetStage(GenStage::kDensity);
+    }
+    if (chunk.GetStage() < GenStage::kSurface && target >= GenStage::kSurface) {
+        PaintSurface(chunk.Voxels(), *chunk.GetColumns());
+        chunk.SetStage(GenStage::kSurface);
+    }
+    if (chunk.GetStage() < GenStage::kDecorated &&
+        target >= GenStage::kDecorated) {
+        Decorate(chunk, coord);
+        chunk.SetStage(GenStage::kDecorated);
+    }
+}
+
+void WorldGenPipeline::Decorate(Chunk& chunk, const ChunkCoord& coord) {
+    PlaceTrees(chunk, [&](const glm::ivec3& local, Voxel::Type vtype) {
+        ChunkCoord neighbor = NeighborOf(local);
+        if (neighbor == ChunkCoord{0, 0}) {
+            if (CanOverwrite(chunk.GetVoxelAtCoord(local), vtype))
+                chunk.AddBlock(local, vtype);
+            return;
+        }
+        Buffer(coord + neighbor,
+               {coord,
+                {util::PositiveMod(local.x, Chunk::kSize_x), local.y,
+                 util::PositiveMod(local.z, Chunk::kSize_z)},
+                vtype});
+    });
+}
+
+void WorldGenPipeline::Buffer(const ChunkCoord&   target,
+                              const PendingWrite& write) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_[target].push_back(write);
+}
+
+size_t WorldGenPipeline::ApplyPendingWrites(Chunk&            chunk,
+                                            const ChunkCoord& coord) {
+    // Keep the writes for the full resolution chunk that replaces this one
+    if (chunk.GetLod() != 1) return 0;
+    std::vector<PendingWrite> writes;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        auto                        it = pending_.find(coord);
+        if (it == pending_.end()) return 0;
+        writes = std::move(it->second);
+        pending_.erase(it);
+    }
+    size_t applied = 0;
+    for (const auto& write : writes) {
+        if (!CanOverwrite(chunk.GetVoxelAtCoord(write.local), write.vtype))
+            continue;
+        chunk.AddBlock(write.local, write.vtype);
+        applied++;
+    }
+    return applied;
+}
+
+void WorldGenPipeline::DropWritesFrom(const ChunkCoord& source) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    for (const auto& off : kOrthogonalNeighbors) {
+        auto it = pending_.find(source + off);
+        if (it == pending_.end()) continue;
+        std::erase_if(it->second, [&](const PendingWrite& write) {
+            return write.source == source;
+        });
+        if (it->second.empty()) pending_.erase(it);
+    }
+}
+
+void WorldGenPipeline::ReplayDecoration(const Chunk&      source,
+                                        const ChunkCoord& sourceCoord,
+                                        const ChunkCoord& target) {
+    if (source.GetStage() < GenStage::kDecorated) return;
+    std::vector<PendingWrite> writes;
+    PlaceTrees(source, [&](const glm::ivec3& local, Voxel::Type vtype) {
+        if (sourceCoord + NeighborOf(local) != target) return;
+        writes.push_back({sourceCoord,
+                          {util::PositiveMod(local.x, Chunk::kSize_x), local.y,
+                           util::PositiveMod(local.z, Chunk::kSize_z)},
+                          vtype});
+    });
+
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    auto&                       buffered = pending_[target];
+    // Replaying twice must not duplicate anything
+    std::erase_if(buffered, [&](const PendingWrite& write) {
+        return write.source == sourceCoord;
+    });
+    buffered.insert(buffered.end(), writes.begin(), writes.end());
+    if (buffered.empty()) pending_.erase(target);
+}
+}  // namespace pop::voxel::terrain
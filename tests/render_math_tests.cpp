@@ -0,0 +1,206 @@
+// GL free checks of the render side math: util::Frustum plane extraction and
+// culling, and gfx::BufferAllocator's free list and stats.
+//
+//   RenderMathTests
+//
+// Prints every failed check and exits with 1 when there was any.
+#include "graphics/buffer_allocator.hpp"
+#include "util/frustum.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <optional>
+
+using namespace pop;
+
+namespace {
+int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, \
+                         __LINE__, #cond);                             \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+// A box of half size 0.5 around center
+util::AABB BoxAt(const glm::vec3& center) {
+    return {center - glm::vec3{0.5f}, center + glm::vec3{0.5f}};
+}
+
+// ==============Frustum==============
+constexpr float kFov = glm::radians(90.0f), kAspect = 1.0f, kNear = 0.1f;
+
+void TestFinitePlanes() {
+    // Camera at the origin looking down -z, far plane at 100
+    util::Frustum frustum{glm::perspective(kFov, kAspect, kNear, 100.0f)};
+    CHECK(frustum.PlaneCount() == 6);
+
+    CHECK(frustum.Intersects(BoxAt({0, 0, -10})));
+    // One box just outside each plane: every normal must face inwards
+    CHECK(!frustum.Intersects(BoxAt({0, 0, 10})));     // behind, near
+    CHECK(!frustum.Intersects(BoxAt({0, 0, -200})));   // far
+    CHECK(!frustum.Intersects(BoxAt({-30, 0, -10})));  // left
+    CHECK(!frustum.Intersects(BoxAt({30, 0, -10})));   // right
+    CHECK(!frustum.Intersects(BoxAt({0, -30, -10})));  // bottom
+    CHECK(!frustum.Intersects(BoxAt({0, 30, -10})));   // top
+    // With a 90 degree fov the side planes are at |x| = -z
+    CHECK(frustum.Intersects(BoxAt({9.8f, 0, -10})));
+    CHECK(!frustum.Intersects(BoxAt({11.1f, 0, -10})));
+    // Boxes straddling a plane are kept
+    CHECK(frustum.Intersects({{-50, -1, -11}, {50, 1, -9}}));
+    CHECK(frustum.Intersects({{-1, -1, -1}, {1, 1, 1}}));
+}
+
+void TestViewTransform() {
+    // Looking down +x from (10, 0, 0): the projection alone would cull it
+    glm::mat4 view = glm::lookAt(glm::vec3{10, 0, 0}, glm::vec3{20, 0, 0},
+                                 glm::vec3{0, 1, 0});
+    util::Frustum frustum{glm::perspective(kFov, kAspect, kNear, 100.0f) *
+                          view};
+    CHECK(frustum.Intersects(BoxAt({30, 0, 0})));
+    CHECK(!frustum.Intersects(BoxAt({0, 0, 0})));
+    CHECK(!frustum.Intersects(BoxAt({15, 0, 20})));
+}
+
+void TestInfiniteFarPlane() {
+    for (const glm::mat4& projection :
+         {glm::infinitePerspective(kFov, kAspect, kNear),
+          glm::tweakedInfinitePerspective(kFov, kAspect, kNear)}) {
+        util::Frustum frustum{projection};
+        // The far plane degenerates and is dropped
+        CHECK(frustum.PlaneCount() == 5);
+        CHECK(frustum.Intersects(BoxAt({0, 0, -1e6f})));
+        CHECK(!frustum.Intersects(BoxAt({0, 0, 10})));
+        CHECK(!frustum.Intersects(BoxAt({-30, 0, -10})));
+        CHECK(!frustum.Intersects(BoxAt({0, 30, -10})));
+    }
+}
+
+// ==============BufferAllocator==============
+using Allocator = gfx::BufferAllocator;
+
+bool Near(float a, float b) { return std::fabs(a - b) < 1e-5f; }
+
+void TestAllocateAndFree() {
+    Allocator allocator{100};
+    CHECK(!allocator.Allocate(0));
+    auto a = allocator.Allocate(30);
+    auto b = allocator.Allocate(30);
+    auto c = allocator.Allocate(40);
+    CHECK(a && a->offset == 0 && a->size == 30);
+    CHECK(b && b->offset == 30);
+    CHECK(c && c->offset == 60);
+    CHECK(!allocator.Allocate(1));  // full
+
+    auto stats = allocator.GetStats();
+    CHECK(stats.used == 100 && stats.freeBlocks == 0 && stats.largestFree == 0);
+    CHECK(Near(stats.fragmentation, 0.0f));
+
+    allocator.Free(*b);
+    CHECK(allocator.GetStats().used == 70);
+    auto again = allocator.Allocate(30);
+    CHECK(again && again->offset == 30);
+}
+
+void TestMerge() {
+    Allocator allocator{100};
+    auto      a = allocator.Allocate(25);
+    auto      b = allocator.Allocate(25);
+    auto      c = allocator.Allocate(25);
+    auto      d = allocator.Allocate(25);
+
+    // Two free blocks that do not touch
+    allocator.Free(*a);
+    allocator.Free(*c);
+    auto stats = allocator.GetStats();
+    CHECK(stats.freeBlocks == 2 && stats.largestFree == 25);
+    CHECK(Near(stats.fragmentation, 0.5f));
+    CHECK(!allocator.Allocate(50));
+
+    // b joins both neighbors into one block
+    allocator.Free(*b);
+    stats = allocator.GetStats();
+    CHECK(stats.freeBlocks == 1 && stats.largestFree == 75);
+    CHECK(Near(stats.fragmentation, 0.0f));
+
+    allocator.Free(*d);
+    stats = allocator.GetStats();
+    CHECK(stats.freeBlocks == 1 && stats.largestFree == 100 &&
+          stats.used == 0);
+    auto all = allocator.Allocate(100);
+    CHECK(all && all->offset == 0);
+}
+
+void TestBestFit() {
+    Allocator allocator{100};
+    auto      a = allocator.Allocate(10);
+    allocator.Allocate(10);
+    auto c = allocator.Allocate(4);
+    allocator.Allocate(76);
+    allocator.Free(*a);  // 10 free at 0
+    allocator.Free(*c);  // 4 free at 20
+    // The smallest block that fits, not the first one
+    auto fit = allocator.Allocate(3);
+    CHECK(fit && fit->offset == 20);
+    fit = allocator.Allocate(8);
+    CHECK(fit && fit->offset == 0);
+}
+
+void TestGrow() {
+    Allocator allocator{50};
+    auto      a = allocator.Allocate(40);
+    // Growing merges with the free tail instead of adding a block
+    allocator.Grow(100);
+    auto stats = allocator.GetStats();
+    CHECK(stats.capacity == 100 && stats.freeBlocks == 1 &&
+          stats.largestFree == 60);
+    auto b = allocator.Allocate(60);
+    CHECK(b && b->offset == 40);
+
+    // Full: the grown space is a new block at the old end
+    allocator.Grow(150);
+    auto c = allocator.Allocate(50);
+    CHECK(c && c->offset == 100);
+    // Shrinking is ignored
+    allocator.Grow(10);
+    CHECK(allocator.Capacity() == 150);
+    allocator.Free(*a);
+    allocator.Free(*b);
+    allocator.Free(*c);
+    CHECK(allocator.GetStats().freeBlocks == 1);
+}
+
+void TestPeak() {
+    Allocator allocator{100};
+    auto      a = allocator.Allocate(60);
+    auto      b = allocator.Allocate(30);
+    allocator.Free(*a);
+    allocator.Free(*b);
+    auto stats = allocator.GetStats();
+    CHECK(stats.used == 0 && stats.peak == 90);
+    allocator.Allocate(20);
+    CHECK(allocator.GetStats().peak == 90);
+}
+}  // namespace
+
+int main() {
+    TestFinitePlanes();
+    TestViewTransform();
+    TestInfiniteFarPlane();
+    TestAllocateAndFree();
+    TestMerge();
+    TestBestFit();
+    TestGrow();
+    TestPeak();
+    if (failures) {
+        std::fprintf(stderr, "FAILED: %d checks\n", failures);
+        return 1;
+    }
+    std::printf("All render math checks passed\n");
+    return 0;
+}